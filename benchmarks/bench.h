@@ -0,0 +1,114 @@
+// Common benchmark support: timing, size sweep, key types and CSV output.
+//
+// Every benchmark program accepts:
+//     -n <maxsize>    largest container size in the sweep (default 4194304)
+//     -o <file.csv>   append results to file instead of writing to stdout
+//
+// Output is CSV, one row per measurement:
+//     container,operation,key,size,hit_ratio,ns_per_op
+#ifndef STC_BENCH_H_INCLUDED
+#define STC_BENCH_H_INCLUDED
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "stc/cstr.h"
+
+#define BENCH_MINSIZE (1 << 10)   // fits in L1
+#define BENCH_MAXSIZE (1 << 22)   // beyond LLC for all key types
+#define BENCH_WORK    (1 << 22)   // elements processed per measurement
+
+static struct {
+    FILE* out;
+    isize maxsize;
+    uint64_t sink; // defeats dead code elimination
+} bench = {NULL, BENCH_MAXSIZE, 0};
+
+static void bench_init(int argc, char* argv[]) {
+    bench.out = stdout;
+    for (int i = 1; i < argc - 1; ++i) {
+        if (!strcmp(argv[i], "-n"))
+            bench.maxsize = atoll(argv[++i]);
+        else if (!strcmp(argv[i], "-o"))
+            bench.out = fopen(argv[++i], "a");
+    }
+    if (bench.out == NULL) {
+        perror("bench");
+        exit(1);
+    }
+    if (bench.out == stdout || (fseek(bench.out, 0, SEEK_END), ftell(bench.out) == 0))
+        fputs("container,operation,key,size,hit_ratio,ns_per_op\n", bench.out);
+}
+
+static void bench_exit(void) {
+    if (bench.out != stdout) fclose(bench.out);
+    if (bench.sink == 42) puts(""); // never true, but the compiler can't know
+}
+
+static inline double bench_now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+// Number of repetitions of an O(n) operation on a container of size n.
+static inline isize bench_reps(isize n)
+    { return n < BENCH_WORK ? BENCH_WORK/n : 1; }
+
+// Deterministic key sequence: key i and key j are distinct for i != j.
+static inline uint64_t bench_mix(uint64_t x) {
+    x = (x ^ (x >> 30))*0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27))*0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+// for (bench_sizes(n)) : sweep container sizes from L1 to beyond LLC
+#define bench_sizes(n) \
+    isize n = BENCH_MINSIZE; n <= bench.maxsize; n *= 4
+
+// elapsed: total nanoseconds spent on ops operations
+static void bench_report(const char* container, const char* op, const char* key,
+                         isize size, double hit_ratio, double elapsed, isize ops) {
+    fprintf(bench.out, "%s,%s,%s,%" c_ZI ",%.2f,%.3f\n", container, op, key,
+                       size, hit_ratio, elapsed/(double)ops);
+    fflush(bench.out);
+}
+
+// Query keys for lookups: a fraction hit_ratio of them are present in a
+// container holding the keys make(0), make(2), .., make(2*(n - 1)).
+static inline uint64_t bench_query(isize i, isize n, double hit_ratio) {
+    uint64_t r = bench_mix((uint64_t)i ^ 0x5bd1e995);
+    return (double)(r % 1000) < hit_ratio*1000 ? 2*(r % (uint64_t)n) : 2*(uint64_t)i + 1;
+}
+
+// Key types. Each type K defines K_make(i), K_toraw(), K_clone(), K_drop(), and
+// K_name used in the output.
+
+// Integer key
+typedef int64_t bint;
+#define bint_name "int"
+static inline bint bint_make(uint64_t i) { return (bint)bench_mix(i); }
+static inline bint bint_toraw(const bint* x) { return *x; }
+static inline bint bint_clone(bint x) { return x; }
+static inline void bint_drop(bint* x) { (void)x; }
+
+// String key: long enough to be heap allocated
+typedef cstr bstr;
+#define bstr_name "cstr"
+static inline bstr bstr_make(uint64_t i)
+    { return cstr_from_fmt("key:%016" PRIx64 ":sessionid", bench_mix(i)); }
+#define bstr_toraw cstr_toraw
+#define bstr_clone cstr_clone
+#define bstr_drop cstr_drop
+
+// Big struct key: compared and hashed by id only
+typedef struct { int64_t id; int64_t payload[15]; } bbig;
+#define bbig_name "big128"
+static inline bbig bbig_make(uint64_t i) { bbig b = {bint_make(i), {0}}; return b; }
+static inline bbig bbig_toraw(const bbig* x) { return *x; }
+static inline bbig bbig_clone(bbig x) { return x; }
+static inline void bbig_drop(bbig* x) { (void)x; }
+static inline int bbig_cmp(const bbig* x, const bbig* y) { return (x->id > y->id) - (x->id < y->id); }
+static inline bool bbig_eq(const bbig* x, const bbig* y) { return x->id == y->id; }
+static inline size_t bbig_hash(const bbig* x) { return c_hash_n(&x->id, 8); }
+
+#endif // STC_BENCH_H_INCLUDED
@@ -0,0 +1,51 @@
+// Benchmark template for pqueue.
+//   #define C    pqueue type
+//   #define K    key type from bench.h
+//   #include "bench_pqueue.h"
+// Defines: void C_bench(const char* name)
+
+#define _bc(name) c_JOIN(C, name)
+#define _bk(name) c_JOIN(K, name)
+
+static void _bc(_bench)(const char* name) {
+    for (bench_sizes(n)) {
+        const isize reps = bench_reps(n);
+        K* keys = (K*)malloc((size_t)n*sizeof *keys);
+        for (c_range(i, n)) keys[i] = _bk(_make)(2*(uint64_t)i);
+        double t0, tsum = 0;
+        C c = {0};
+
+        for (c_range(r, reps)) {
+            _bc(_drop)(&c);
+            c = _bc(_init)();
+            t0 = bench_now();
+            for (c_range(i, n)) _bc(_push)(&c, _bk(_clone)(keys[i]));
+            tsum += bench_now() - t0;
+        }
+        bench_report(name, "insert", _bk(_name), n, 0, tsum, n*reps);
+
+        t0 = bench_now();
+        for (c_range(r, reps)) {
+            C d = _bc(_clone)(c);
+            bench.sink += (uint64_t)_bc(_size)(&d);
+            _bc(_drop)(&d);
+        }
+        bench_report(name, "clone", _bk(_name), n, 0, bench_now() - t0, n*reps);
+
+        t0 = bench_now();
+        while (!_bc(_is_empty)(&c)) {
+            bench.sink += *(const unsigned char*)_bc(_top)(&c);
+            _bc(_pop)(&c);
+        }
+        bench_report(name, "erase", _bk(_name), n, 0, bench_now() - t0, n);
+
+        _bc(_drop)(&c);
+        for (c_range(i, n)) _bk(_drop)(&keys[i]);
+        free(keys);
+    }
+}
+
+#undef _bc
+#undef _bk
+#undef C
+#undef K
@@ -0,0 +1,77 @@
+// Benchmark template for random access sequences (vec, deque).
+//   #define C    container type, with i_use_cmp enabled
+//   #define K    key type from bench.h
+//   #define POP  member function to remove one element, e.g. _pop or _pop_front
+//   #include "bench_seq.h"
+// Defines: void C_bench(const char* name)
+
+#define _bc(name) c_JOIN(C, name)
+#define _bk(name) c_JOIN(K, name)
+
+static void _bc(_bench)(const char* name) {
+    for (bench_sizes(n)) {
+        const isize reps = bench_reps(n), nq = n < 1<<16 ? 1<<16 : n;
+        K* keys = (K*)malloc((size_t)n*sizeof *keys);
+        for (c_range(i, n)) keys[i] = _bk(_make)(2*(uint64_t)i);
+        double t0, tsum = 0;
+        C c = {0};
+
+        for (c_range(r, reps)) {
+            _bc(_drop)(&c);
+            c = _bc(_init)();
+            t0 = bench_now();
+            for (c_range(i, n)) _bc(_push_back)(&c, _bk(_clone)(keys[i]));
+            tsum += bench_now() - t0;
+        }
+        bench_report(name, "insert", _bk(_name), n, 0, tsum, n*reps);
+
+        t0 = bench_now();
+        for (c_range(r, reps))
+            for (c_each(it, C, c)) bench.sink += *(const unsigned char*)it.ref;
+        bench_report(name, "iterate", _bk(_name), n, 0, bench_now() - t0, n*reps);
+
+        tsum = 0;
+        for (c_range(r, reps < 16 ? reps : 16)) {
+            C d = _bc(_clone)(c);
+            t0 = bench_now();
+            _bc(_sort)(&d);
+            tsum += bench_now() - t0;
+            _bc(_drop)(&d);
+        }
+        bench_report(name, "sort", _bk(_name), n, 0, tsum, n*(reps < 16 ? reps : 16));
+
+        _bc(_sort)(&c);
+        for (c_items(h, double, {0.0, 0.5, 1.0})) {
+            K* q = (K*)malloc((size_t)nq*sizeof *q);
+            for (c_range(i, nq)) q[i] = _bk(_make)(bench_query(i, n, *h.ref));
+            t0 = bench_now();
+            for (c_range(i, nq))
+                bench.sink += (uint64_t)_bc(_binary_search)(&c, _bk(_toraw)(&q[i]));
+            bench_report(name, "find", _bk(_name), n, *h.ref, bench_now() - t0, nq);
+            for (c_range(i, nq)) _bk(_drop)(&q[i]);
+            free(q);
+        }
+
+        t0 = bench_now();
+        for (c_range(r, reps)) {
+            C d = _bc(_clone)(c);
+            bench.sink += (uint64_t)_bc(_size)(&d);
+            _bc(_drop)(&d);
+        }
+        bench_report(name, "clone", _bk(_name), n, 0, bench_now() - t0, n*reps);
+
+        t0 = bench_now();
+        while (!_bc(_is_empty)(&c)) c_JOIN(C, POP)(&c);
+        bench_report(name, "erase", _bk(_name), n, 0, bench_now() - t0, n);
+
+        _bc(_drop)(&c);
+        for (c_range(i, n)) _bk(_drop)(&keys[i]);
+        free(keys);
+    }
+}
+
+#undef _bc
+#undef _bk
+#undef C
+#undef K
+#undef POP
@@ -0,0 +1,33 @@
+#include "bench.h"
+
+#define i_type bmap_bint, bint, int64_t
+#include "stc/bmap.h"
+
+#define i_type bmap_bstr
+#define i_keypro cstr
+#define i_val int64_t
+#include "stc/bmap.h"
+
+#define i_type bmap_bbig, bbig, int64_t
+#define i_cmp bbig_cmp
+#include "stc/bmap.h"
+
+#define C bmap_bint
+#define K bint
+#include "bench_map.h"
+
+#define C bmap_bstr
+#define K bstr
+#include "bench_map.h"
+
+#define C bmap_bbig
+#define K bbig
+#include "bench_map.h"
+
+int main(int argc, char* argv[]) {
+    bench_init(argc, argv);
+    bmap_bint_bench("bmap");
+    bmap_bstr_bench("bmap");
+    bmap_bbig_bench("bmap");
+    bench_exit();
+}
@@ -0,0 +1,81 @@
+#include "bench.h"
+
+// Strings of n bytes built from a pseudo random lower case alphabet.
+// Times are per byte for the operations that process the whole string.
+
+static void cstr_bench(const char* name) {
+    const char* needle = "ZZtimeoutZZ";
+    for (bench_sizes(n)) {
+        const isize reps = bench_reps(n);
+        char chunk[17] = {0};
+        double t0, tsum = 0;
+        cstr s = {0};
+
+        for (c_range(r, reps)) {
+            cstr_drop(&s);
+            s = cstr_init();
+            t0 = bench_now();
+            for (isize i = 0; i < n; i += 16) {
+                for (c_range(j, 16)) chunk[j] = (char)('a' + (bench_mix((uint64_t)(i + j)) % 26));
+                cstr_append_n(&s, chunk, 16);
+            }
+            tsum += bench_now() - t0;
+        }
+        bench_report(name, "insert", "char", n, 0, tsum, n*reps);
+
+        t0 = bench_now();
+        for (c_range(r, reps))
+            for (c_each(it, cstr, s)) bench.sink += (uint64_t)it.chr.size;
+        bench_report(name, "iterate", "char", n, 0, bench_now() - t0, n*reps);
+
+        for (c_items(h, double, {0.0, 0.5, 1.0})) {
+            cstr t = cstr_clone(s);
+            if (*h.ref > 0) // place the needle at the hit ratio position
+                cstr_replace_at(&t, (isize)((double)(n - 16)**h.ref), c_strlen(needle), needle);
+            t0 = bench_now();
+            for (c_range(r, reps))
+                bench.sink += (uint64_t)cstr_find(&t, needle);
+            bench_report(name, "find", "char", n, *h.ref, bench_now() - t0, n*reps);
+            cstr_drop(&t);
+        }
+
+        t0 = bench_now();
+        for (c_range(r, reps)) {
+            cstr t = cstr_clone(s);
+            bench.sink += (uint64_t)cstr_size(&t);
+            cstr_drop(&t);
+        }
+        bench_report(name, "clone", "char", n, 0, bench_now() - t0, n*reps);
+
+        t0 = bench_now();
+        for (c_range(r, reps < 16 ? reps : 16)) {
+            cstr t = cstr_clone(s);
+            cstr_replace(&t, "ab", "xyz");
+            bench.sink += (uint64_t)cstr_size(&t);
+            cstr_drop(&t);
+        }
+        bench_report(name, "replace", "char", n, 0, bench_now() - t0, n*(reps < 16 ? reps : 16));
+
+        t0 = bench_now();
+        for (c_range(64)) cstr_erase(&s, cstr_size(&s)/2, 16);
+        bench_report(name, "erase", "char", n, 0, bench_now() - t0, 64);
+        cstr_drop(&s);
+
+        // short (sso) and long strings created from raw
+        for (c_items(len, int, {15, 40})) {
+            t0 = bench_now();
+            for (c_range(i, n)) {
+                cstr t = cstr_from_n("0123456789abcdef0123456789abcdef01234567", *len.ref);
+                bench.sink += (uint64_t)cstr_size(&t);
+                cstr_drop(&t);
+            }
+            bench_report(name, "from", *len.ref < 16 ? "sso" : "heap", n, 0, bench_now() - t0, n);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bench_init(argc, argv);
+    cstr_bench("cstr");
+    bench_exit();
+}
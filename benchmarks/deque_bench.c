@@ -0,0 +1,36 @@
+#include "bench.h"
+
+#define i_type deque_bint, bint, (c_use_cmp)
+#include "stc/deque.h"
+
+#define i_type deque_bstr
+#define i_keypro cstr
+#define i_use_cmp
+#include "stc/deque.h"
+
+#define i_type deque_bbig, bbig
+#define i_cmp bbig_cmp
+#include "stc/deque.h"
+
+#define C deque_bint
+#define K bint
+#define POP _pop_front
+#include "bench_seq.h"
+
+#define C deque_bstr
+#define K bstr
+#define POP _pop_front
+#include "bench_seq.h"
+
+#define C deque_bbig
+#define K bbig
+#define POP _pop_front
+#include "bench_seq.h"
+
+int main(int argc, char* argv[]) {
+    bench_init(argc, argv);
+    deque_bint_bench("deque");
+    deque_bstr_bench("deque");
+    deque_bbig_bench("deque");
+    bench_exit();
+}
@@ -0,0 +1,34 @@
+#include "bench.h"
+
+#define i_type hmap_bint, bint, int64_t
+#include "stc/hashmap.h"
+
+#define i_type hmap_bstr
+#define i_keypro cstr
+#define i_val int64_t
+#include "stc/hashmap.h"
+
+#define i_type hmap_bbig, bbig, int64_t
+#define i_eq bbig_eq
+#define i_hash bbig_hash
+#include "stc/hashmap.h"
+
+#define C hmap_bint
+#define K bint
+#include "bench_map.h"
+
+#define C hmap_bstr
+#define K bstr
+#include "bench_map.h"
+
+#define C hmap_bbig
+#define K bbig
+#include "bench_map.h"
+
+int main(int argc, char* argv[]) {
+    bench_init(argc, argv);
+    hmap_bint_bench("hmap");
+    hmap_bstr_bench("hmap");
+    hmap_bbig_bench("hmap");
+    bench_exit();
+}
@@ -0,0 +1,33 @@
+#include "bench.h"
+
+#define i_type list_bint, bint, (c_use_cmp)
+#include "stc/list.h"
+
+#define i_type list_bstr
+#define i_keypro cstr
+#define i_use_cmp
+#include "stc/list.h"
+
+#define i_type list_bbig, bbig
+#define i_cmp bbig_cmp
+#include "stc/list.h"
+
+#define C list_bint
+#define K bint
+#include "bench_list.h"
+
+#define C list_bstr
+#define K bstr
+#include "bench_list.h"
+
+#define C list_bbig
+#define K bbig
+#include "bench_list.h"
+
+int main(int argc, char* argv[]) {
+    bench_init(argc, argv);
+    list_bint_bench("list");
+    list_bstr_bench("list");
+    list_bbig_bench("list");
+    bench_exit();
+}
@@ -0,0 +1,32 @@
+#include "bench.h"
+
+#define i_type pqueue_bint, bint
+#include "stc/pqueue.h"
+
+#define i_type pqueue_bstr
+#define i_keyclass cstr
+#include "stc/pqueue.h"
+
+#define i_type pqueue_bbig, bbig
+#define i_cmp bbig_cmp
+#include "stc/pqueue.h"
+
+#define C pqueue_bint
+#define K bint
+#include "bench_pqueue.h"
+
+#define C pqueue_bstr
+#define K bstr
+#include "bench_pqueue.h"
+
+#define C pqueue_bbig
+#define K bbig
+#include "bench_pqueue.h"
+
+int main(int argc, char* argv[]) {
+    bench_init(argc, argv);
+    pqueue_bint_bench("pqueue");
+    pqueue_bstr_bench("pqueue");
+    pqueue_bbig_bench("pqueue");
+    bench_exit();
+}
@@ -0,0 +1,33 @@
+#include "bench.h"
+
+#define i_type smap_bint, bint, int64_t
+#include "stc/sortedmap.h"
+
+#define i_type smap_bstr
+#define i_keypro cstr
+#define i_val int64_t
+#include "stc/sortedmap.h"
+
+#define i_type smap_bbig, bbig, int64_t
+#define i_cmp bbig_cmp
+#include "stc/sortedmap.h"
+
+#define C smap_bint
+#define K bint
+#include "bench_map.h"
+
+#define C smap_bstr
+#define K bstr
+#include "bench_map.h"
+
+#define C smap_bbig
+#define K bbig
+#include "bench_map.h"
+
+int main(int argc, char* argv[]) {
+    bench_init(argc, argv);
+    smap_bint_bench("smap");
+    smap_bstr_bench("smap");
+    smap_bbig_bench("smap");
+    bench_exit();
+}
@@ -0,0 +1,36 @@
+#include "bench.h"
+
+#define i_type vec_bint, bint, (c_use_cmp)
+#include "stc/vec.h"
+
+#define i_type vec_bstr
+#define i_keypro cstr
+#define i_use_cmp
+#include "stc/vec.h"
+
+#define i_type vec_bbig, bbig
+#define i_cmp bbig_cmp
+#include "stc/vec.h"
+
+#define C vec_bint
+#define K bint
+#define POP _pop
+#include "bench_seq.h"
+
+#define C vec_bstr
+#define K bstr
+#define POP _pop
+#include "bench_seq.h"
+
+#define C vec_bbig
+#define K bbig
+#define POP _pop
+#include "bench_seq.h"
+
+int main(int argc, char* argv[]) {
+    bench_init(argc, argv);
+    vec_bint_bench("vec");
+    vec_bstr_bench("vec");
+    vec_bbig_bench("vec");
+    bench_exit();
+}
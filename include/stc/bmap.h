@@ -0,0 +1,776 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Sorted/Ordered set and map - implemented as a B+tree.
+// Values are stored in leaf nodes of about 512 bytes, linked in order for iteration.
+// Inner nodes hold shallow copies of the smallest key in each child except the first,
+// so a lookup touches one node per level. Same API as smap.
+/*
+#include <stdio.h>
+#define i_type BMap, int, double
+#include "stc/bmap.h"
+
+int main(void) {
+    BMap m = {0};
+    for (c_range32(i, 100000))
+        BMap_insert(&m, i*2, i*0.5);
+
+    for (BMap_iter i = BMap_lower_bound(&m, 99991); i.ref && i.ref->first <= 100010; BMap_next(&i)) {
+        printf(" %d: %g\n", i.ref->first, i.ref->second);
+    }
+    BMap_drop(&m);
+}
+*/
+#include "priv/linkage.h"
+#include "types.h"
+
+#ifndef STC_BMAP_H_INCLUDED
+#define STC_BMAP_H_INCLUDED
+#include "common.h"
+#include <stdlib.h>
+#endif // STC_BMAP_H_INCLUDED
+
+#ifndef _i_prefix
+  #define _i_prefix bmap_
+#endif
+#ifndef _i_is_set
+  #define _i_is_map
+  #define _i_MAP_ONLY c_true
+  #define _i_SET_ONLY c_false
+  #define _i_keyref(vp) (&(vp)->first)
+#else
+  #define _i_MAP_ONLY c_false
+  #define _i_SET_ONLY c_true
+  #define _i_keyref(vp) (vp)
+#endif
+#define _i_sorted
+#include "priv/template.h"
+#ifndef i_declared
+  _c_DEFTYPES(_c_btree_types, Self, i_key, i_val, _i_MAP_ONLY, _i_SET_ONLY);
+#endif
+
+_i_MAP_ONLY( struct _m_value {
+    _m_key first;
+    _m_mapped second;
+}; )
+
+#define _b_LEAF_CAP ((int)(496/sizeof(_m_value)) > 4 ? (int)(496/sizeof(_m_value)) : 4)
+#define _b_INNER_CAP ((int)(512/(sizeof(_m_key) + sizeof(void*))) > 4 ? \
+                      (int)(512/(sizeof(_m_key) + sizeof(void*))) : 4)
+#define _b_inner struct _c_MEMB(_inner_)
+#define _b_path struct _c_MEMB(_path_)
+#define _m_leaf _c_MEMB(_leaf)
+
+struct _c_MEMB(_leaf) {
+    struct _c_MEMB(_leaf)* next;
+    int n;
+    _m_value values[_b_LEAF_CAP];
+};
+
+_b_inner {
+    int n; // number of children
+    _m_key keys[_b_INNER_CAP - 1]; // keys[i]: shallow copy of the smallest key below child[i + 1]
+    void* child[_b_INNER_CAP];
+};
+
+_b_path { _b_inner* node; int idx; }; // the nodes above a leaf, and the child taken
+
+typedef i_keyraw _m_keyraw;
+typedef i_valraw _m_rmapped;
+typedef _i_SET_ONLY( _m_keyraw )
+        _i_MAP_ONLY( struct { _m_keyraw first; _m_rmapped second; } )
+        _m_raw;
+
+#if !defined i_no_emplace
+STC_API _m_result       _c_MEMB(_emplace)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped));
+#endif // !i_no_emplace
+#if !defined i_no_clone
+STC_API Self            _c_MEMB(_clone)(Self tree);
+#endif // !i_no_clone
+STC_API void            _c_MEMB(_drop)(const Self* cself);
+STC_API _m_value*       _c_MEMB(_find_it)(const Self* self, _m_keyraw rkey, _m_iter* out);
+STC_API _m_iter         _c_MEMB(_lower_bound)(const Self* self, _m_keyraw rkey);
+STC_API _m_value*       _c_MEMB(_front)(const Self* self);
+STC_API _m_value*       _c_MEMB(_back)(const Self* self);
+STC_API int             _c_MEMB(_erase)(Self* self, _m_keyraw rkey);
+STC_API _m_iter         _c_MEMB(_erase_at)(Self* self, _m_iter it);
+STC_API _m_iter         _c_MEMB(_erase_range)(Self* self, _m_iter it1, _m_iter it2);
+STC_API _m_iter         _c_MEMB(_begin)(const Self* self);
+
+STC_INLINE Self         _c_MEMB(_init)(void) { Self tree = {0}; return tree; }
+STC_INLINE bool         _c_MEMB(_is_empty)(const Self* cx) { return cx->size == 0; }
+STC_INLINE isize        _c_MEMB(_size)(const Self* cx) { return cx->size; }
+STC_INLINE _m_iter      _c_MEMB(_find)(const Self* self, _m_keyraw rkey)
+                            { _m_iter it; _c_MEMB(_find_it)(self, rkey, &it); return it; }
+STC_INLINE bool         _c_MEMB(_contains)(const Self* self, _m_keyraw rkey)
+                            { _m_iter it; return _c_MEMB(_find_it)(self, rkey, &it) != NULL; }
+STC_INLINE const _m_value* _c_MEMB(_get)(const Self* self, _m_keyraw rkey)
+                            { _m_iter it; return _c_MEMB(_find_it)(self, rkey, &it); }
+STC_INLINE _m_value*    _c_MEMB(_get_mut)(Self* self, _m_keyraw rkey)
+                            { _m_iter it; return _c_MEMB(_find_it)(self, rkey, &it); }
+
+STC_INLINE void _c_MEMB(_clear)(Self* self)
+    { _c_MEMB(_drop)(self); self->root = NULL, self->size = 0, self->height = 0; }
+
+STC_INLINE _m_raw _c_MEMB(_value_toraw)(const _m_value* val) {
+    return _i_SET_ONLY( i_keytoraw(val) )
+           _i_MAP_ONLY( c_literal(_m_raw){i_keytoraw((&val->first)),
+                                          i_valtoraw((&val->second))} );
+}
+
+STC_INLINE void _c_MEMB(_value_drop)(_m_value* val) {
+    i_keydrop(_i_keyref(val));
+    _i_MAP_ONLY( i_valdrop((&val->second)); )
+}
+
+STC_INLINE Self _c_MEMB(_move)(Self *self) {
+    Self m = *self;
+    self->root = NULL, self->size = 0, self->height = 0;
+    return m;
+}
+
+STC_INLINE void _c_MEMB(_take)(Self *self, Self unowned) {
+    _c_MEMB(_drop)(self);
+    *self = unowned;
+}
+
+#if !defined i_no_clone
+STC_INLINE _m_value _c_MEMB(_value_clone)(_m_value _val) {
+    *_i_keyref(&_val) = i_keyclone((*_i_keyref(&_val)));
+    _i_MAP_ONLY( _val.second = i_valclone(_val.second); )
+    return _val;
+}
+
+STC_INLINE void _c_MEMB(_copy)(Self *self, const Self other) {
+    if (self->root == other.root)
+        return;
+    _c_MEMB(_drop)(self);
+    *self = _c_MEMB(_clone)(other);
+}
+#endif // !i_no_clone
+
+STC_API _m_result _c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey);
+
+#ifdef _i_is_map
+    STC_API _m_result _c_MEMB(_insert_or_assign)(Self* self, _m_key key, _m_mapped mapped);
+    #ifndef i_no_emplace
+    STC_API _m_result _c_MEMB(_emplace_or_assign)(Self* self, _m_keyraw rkey, _m_rmapped rmapped);
+    #endif
+
+    STC_INLINE const _m_mapped* _c_MEMB(_at)(const Self* self, _m_keyraw rkey) {
+        _m_iter it;
+        _m_value* ref = _c_MEMB(_find_it)(self, rkey, &it);
+        c_assert(ref);
+        return &ref->second;
+    }
+
+    STC_INLINE _m_mapped* _c_MEMB(_at_mut)(Self* self, _m_keyraw rkey)
+        { return (_m_mapped*)_c_MEMB(_at)(self, rkey); }
+#endif // _i_is_map
+
+STC_INLINE _m_iter _c_MEMB(_end)(const Self* self) {
+    _m_iter it; (void)self;
+    it.ref = it._end = NULL, it._leaf = NULL;
+    return it;
+}
+
+STC_INLINE void _c_MEMB(_next)(_m_iter* it) {
+    if (++it->ref == it->_end) {
+        _m_leaf* leaf = it->_leaf = it->_leaf->next;
+        if (leaf) it->ref = leaf->values, it->_end = leaf->values + leaf->n;
+        else it->ref = NULL;
+    }
+}
+
+STC_INLINE _m_iter _c_MEMB(_advance)(_m_iter it, size_t n) {
+    while (n && it.ref) { // skip whole leaves when possible
+        size_t k = (size_t)(it._end - it.ref);
+        if (n < k) { it.ref += n; break; }
+        it.ref = it._end - 1, n -= k - 1;
+        _c_MEMB(_next)(&it), --n;
+    }
+    return it;
+}
+
+#if defined _i_has_eq
+STC_INLINE bool
+_c_MEMB(_eq)(const Self* self, const Self* other) {
+    if (_c_MEMB(_size)(self) != _c_MEMB(_size)(other)) return false;
+    _m_iter i = _c_MEMB(_begin)(self), j = _c_MEMB(_begin)(other);
+    for (; i.ref; _c_MEMB(_next)(&i), _c_MEMB(_next)(&j)) {
+        const _m_keyraw _rx = i_keytoraw(_i_keyref(i.ref)), _ry = i_keytoraw(_i_keyref(j.ref));
+        if (!(i_eq((&_rx), (&_ry)))) return false;
+    }
+    return true;
+}
+#endif
+
+STC_INLINE _m_result
+_c_MEMB(_insert)(Self* self, _m_key _key _i_MAP_ONLY(, _m_mapped _mapped)) {
+    _m_result _res = _c_MEMB(_insert_entry_)(self, i_keytoraw((&_key)));
+    if (_res.inserted)
+        { *_i_keyref(_res.ref) = _key; _i_MAP_ONLY( _res.ref->second = _mapped; )}
+    else
+        { i_keydrop((&_key)); _i_MAP_ONLY( i_valdrop((&_mapped)); )}
+    return _res;
+}
+
+STC_INLINE _m_value* _c_MEMB(_push)(Self* self, _m_value _val) {
+    _m_result _res = _c_MEMB(_insert_entry_)(self, i_keytoraw(_i_keyref(&_val)));
+    if (_res.inserted)
+        *_res.ref = _val;
+    else
+        _c_MEMB(_value_drop)(&_val);
+    return _res.ref;
+}
+
+#ifdef _i_is_map
+STC_INLINE _m_result _c_MEMB(_put)(Self* self, _m_keyraw rkey, _m_rmapped rmapped) {
+    #ifdef i_no_emplace
+        return _c_MEMB(_insert_or_assign)(self, rkey, rmapped);
+    #else
+        return _c_MEMB(_emplace_or_assign)(self, rkey, rmapped);
+    #endif
+}
+#endif
+
+STC_INLINE void _c_MEMB(_put_n)(Self* self, const _m_raw* raw, isize n) {
+    while (n--)
+        #if defined _i_is_set && defined i_no_emplace
+            _c_MEMB(_insert)(self, *raw++);
+        #elif defined _i_is_set
+            _c_MEMB(_emplace)(self, *raw++);
+        #else
+            _c_MEMB(_put)(self, raw->first, raw->second), ++raw;
+        #endif
+}
+
+STC_INLINE Self _c_MEMB(_from_n)(const _m_raw* raw, isize n)
+    { Self cx = {0}; _c_MEMB(_put_n)(&cx, raw, n); return cx; }
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+#if defined i_implement
+enum { _c_MEMB(_maxheight_) = 64 };
+
+// Index of the first value in leaf with key >= rkey.
+static inline int
+_c_MEMB(_leaf_lower_)(const _m_leaf* leaf, const _m_keyraw* rkey) {
+    int lo = 0, hi = leaf->n;
+    while (lo < hi) {
+        const int mid = (lo + hi)/2;
+        const _m_keyraw _raw = i_keytoraw(_i_keyref(&leaf->values[mid]));
+        if (i_less((&_raw), rkey)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Index of the child which may hold rkey.
+static inline int
+_c_MEMB(_inner_child_)(const _b_inner* in, const _m_keyraw* rkey) {
+    int lo = 0, hi = in->n - 1;
+    while (lo < hi) {
+        const int mid = (lo + hi)/2;
+        const _m_keyraw _raw = i_keytoraw((&in->keys[mid]));
+        if (i_less(rkey, (&_raw))) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
+}
+
+static inline _m_leaf*
+_c_MEMB(_find_leaf_)(const Self* self, const _m_keyraw* rkey) {
+    void* node = self->root;
+    for (int h = self->height; h > 0; --h)
+        node = ((_b_inner*)node)->child[_c_MEMB(_inner_child_)((_b_inner*)node, rkey)];
+    return (_m_leaf*)node;
+}
+
+static _m_key
+_c_MEMB(_min_key_)(void* node, int height) {
+    while (height--)
+        node = ((_b_inner*)node)->child[0];
+    return *_i_keyref(&((_m_leaf*)node)->values[0]);
+}
+
+static _m_iter
+_c_MEMB(_iter_at_)(_m_leaf* leaf, int idx) {
+    _m_iter it = {NULL};
+    if (leaf && idx == leaf->n)
+        leaf = leaf->next, idx = 0;
+    if (leaf) {
+        it.ref = leaf->values + idx;
+        it._end = leaf->values + leaf->n;
+        it._leaf = leaf;
+    }
+    return it;
+}
+
+STC_DEF _m_iter
+_c_MEMB(_begin)(const Self* self) {
+    void* node = self->root;
+    if (node == NULL) return _c_MEMB(_end)(self);
+    for (int h = self->height; h > 0; --h)
+        node = ((_b_inner*)node)->child[0];
+    return _c_MEMB(_iter_at_)((_m_leaf*)node, 0);
+}
+
+STC_DEF _m_value*
+_c_MEMB(_front)(const Self* self)
+    { return _c_MEMB(_begin)(self).ref; }
+
+STC_DEF _m_value*
+_c_MEMB(_back)(const Self* self) {
+    void* node = self->root;
+    if (node == NULL) return NULL;
+    for (int h = self->height; h > 0; --h)
+        node = ((_b_inner*)node)->child[((_b_inner*)node)->n - 1];
+    return &((_m_leaf*)node)->values[((_m_leaf*)node)->n - 1];
+}
+
+STC_DEF _m_value*
+_c_MEMB(_find_it)(const Self* self, _m_keyraw rkey, _m_iter* out) {
+    *out = _c_MEMB(_end)(self);
+    if (self->root == NULL) return NULL;
+    _m_leaf* leaf = _c_MEMB(_find_leaf_)(self, &rkey);
+    const int i = _c_MEMB(_leaf_lower_)(leaf, &rkey);
+    if (i < leaf->n) {
+        const _m_keyraw _raw = i_keytoraw(_i_keyref(&leaf->values[i]));
+        if (!(i_less((&rkey), (&_raw))))
+            *out = _c_MEMB(_iter_at_)(leaf, i);
+    }
+    return out->ref;
+}
+
+STC_DEF _m_iter
+_c_MEMB(_lower_bound)(const Self* self, _m_keyraw rkey) {
+    if (self->root == NULL) return _c_MEMB(_end)(self);
+    _m_leaf* leaf = _c_MEMB(_find_leaf_)(self, &rkey);
+    return _c_MEMB(_iter_at_)(leaf, _c_MEMB(_leaf_lower_)(leaf, &rkey));
+}
+
+// Insert a child and its separator key at position c in a full inner node: split it
+// into in and rin. Returns the separator for rin.
+static _m_key
+_c_MEMB(_split_inner_)(_b_inner* in, _b_inner* rin, int c, _m_key key, void* child) {
+    _m_key keys[_b_INNER_CAP];
+    void* children[_b_INNER_CAP + 1];
+    const int total = _b_INNER_CAP + 1, nl = (total + 1)/2;
+    c_memcpy(children, in->child, c*c_sizeof(void*));
+    children[c] = child;
+    c_memcpy(children + c + 1, in->child + c, (in->n - c)*c_sizeof(void*));
+    c_memcpy(keys, in->keys, (c - 1)*c_sizeof(_m_key));
+    keys[c - 1] = key;
+    c_memcpy(keys + c, in->keys + c - 1, (in->n - c)*c_sizeof(_m_key));
+
+    in->n = nl;
+    c_memcpy(in->child, children, nl*c_sizeof(void*));
+    c_memcpy(in->keys, keys, (nl - 1)*c_sizeof(_m_key));
+    rin->n = total - nl;
+    c_memcpy(rin->child, children + nl, rin->n*c_sizeof(void*));
+    c_memcpy(rin->keys, keys + nl, (rin->n - 1)*c_sizeof(_m_key));
+    return keys[nl - 1];
+}
+
+STC_DEF _m_result
+_c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey) {
+    _m_result res = {NULL};
+    _b_path path[_c_MEMB(_maxheight_)];
+    if (self->root == NULL) {
+        _m_leaf* leaf = (_m_leaf*)i_malloc(c_sizeof(_m_leaf));
+        if (leaf == NULL) return res;
+        leaf->next = NULL, leaf->n = 0;
+        self->root = leaf, self->height = 0;
+    }
+    void* node = self->root;
+    for (int h = 0; h < self->height; ++h) {
+        _b_inner* in = (_b_inner*)node;
+        path[h].node = in;
+        path[h].idx = _c_MEMB(_inner_child_)(in, &rkey);
+        node = in->child[path[h].idx];
+    }
+    _m_leaf* leaf = (_m_leaf*)node;
+    int i = _c_MEMB(_leaf_lower_)(leaf, &rkey);
+    if (i < leaf->n) {
+        const _m_keyraw _raw = i_keytoraw(_i_keyref(&leaf->values[i]));
+        if (!(i_less((&rkey), (&_raw))))
+            { res.ref = &leaf->values[i]; return res; }
+    }
+
+    if (leaf->n == _b_LEAF_CAP) {
+        // Allocate all nodes needed for splitting up the path before modifying anything.
+        void* fresh[_c_MEMB(_maxheight_) + 2];
+        int h = self->height - 1, nfresh = 1, f;
+        while (h >= 0 && path[h].node->n == _b_INNER_CAP) --h, ++nfresh;
+        if (h < 0) ++nfresh; // new root
+        for (f = 0; f < nfresh; ++f) {
+            fresh[f] = i_malloc(f == 0 ? c_sizeof(_m_leaf) : c_sizeof(_b_inner));
+            if (fresh[f] == NULL) {
+                while (f--) i_free(fresh[f], f == 0 ? c_sizeof(_m_leaf) : c_sizeof(_b_inner));
+                return res;
+            }
+        }
+        _m_leaf* right = (_m_leaf*)fresh[0];
+        const int mid = _b_LEAF_CAP/2;
+        right->n = _b_LEAF_CAP - mid;
+        c_memcpy(right->values, leaf->values + mid, right->n*c_sizeof(_m_value));
+        right->next = leaf->next;
+        leaf->next = right;
+        leaf->n = mid;
+        if (i > mid) // at i == mid, insert at the end of leaf: right->values[0] is the separator
+            leaf = right, i -= mid;
+
+        _m_key sep = *_i_keyref(&right->values[0]);
+        void* child = right;
+        for (h = self->height - 1, f = 1; ; --h) {
+            if (h < 0) {
+                _b_inner* root = (_b_inner*)fresh[f++];
+                root->n = 2;
+                root->keys[0] = sep;
+                root->child[0] = self->root;
+                root->child[1] = child;
+                self->root = root;
+                ++self->height;
+                break;
+            }
+            _b_inner* in = path[h].node;
+            const int c = path[h].idx + 1;
+            if (in->n < _b_INNER_CAP) {
+                c_memmove(in->child + c + 1, in->child + c, (in->n - c)*c_sizeof(void*));
+                c_memmove(in->keys + c, in->keys + c - 1, (in->n - c)*c_sizeof(_m_key));
+                in->child[c] = child;
+                in->keys[c - 1] = sep;
+                ++in->n;
+                break;
+            }
+            _b_inner* rin = (_b_inner*)fresh[f++];
+            sep = _c_MEMB(_split_inner_)(in, rin, c, sep, child);
+            child = rin;
+        }
+    }
+    c_memmove(leaf->values + i + 1, leaf->values + i, (leaf->n - i)*c_sizeof(_m_value));
+    ++leaf->n;
+    ++self->size;
+    res.ref = &leaf->values[i];
+    res.inserted = true;
+    return res;
+}
+
+// Remove child[j] and keys[j - 1] from an inner node.
+static void
+_c_MEMB(_remove_child_)(_b_inner* in, int j) {
+    c_memmove(in->child + j, in->child + j + 1, (in->n - j - 1)*c_sizeof(void*));
+    c_memmove(in->keys + j - 1, in->keys + j, (in->n - j - 1)*c_sizeof(_m_key));
+    --in->n;
+}
+
+// Refill child c of in, at the given height, from a sibling if it has underflowed.
+// Returns the new index of the child.
+static int
+_c_MEMB(_rebalance_)(Self* self, _b_inner* in, int c, int height) {
+    (void)self; // used by i_free() with i_allocator_ctx
+    if (height == 0) {
+        enum { MIN = _b_LEAF_CAP/2 };
+        _m_leaf *x = (_m_leaf*)in->child[c], *y;
+        if (x->n >= MIN) return c;
+        // An empty leaf (only left by erase_range) is merged: borrowing would move
+        // in values that are about to be erased, one at a time.
+        if (x->n > 0 && c > 0 && (y = (_m_leaf*)in->child[c - 1])->n > MIN) {
+            c_memmove(x->values + 1, x->values, x->n*c_sizeof(_m_value));
+            x->values[0] = y->values[--y->n];
+            ++x->n;
+            return c;
+        }
+        if (x->n > 0 && c < in->n - 1 && (y = (_m_leaf*)in->child[c + 1])->n > MIN) {
+            x->values[x->n++] = y->values[0];
+            c_memmove(y->values, y->values + 1, --y->n*c_sizeof(_m_value));
+            return c;
+        }
+        if (c > 0) // merge x into left sibling
+            y = x, x = (_m_leaf*)in->child[--c];
+        else
+            y = (_m_leaf*)in->child[c + 1];
+        c_memcpy(x->values + x->n, y->values, y->n*c_sizeof(_m_value));
+        x->n += y->n;
+        x->next = y->next;
+        i_free(y, c_sizeof(_m_leaf));
+    } else {
+        enum { MIN = _b_INNER_CAP/2 };
+        _b_inner *x = (_b_inner*)in->child[c], *y;
+        if (x->n >= MIN) return c;
+        if (c > 0 && (y = (_b_inner*)in->child[c - 1])->n > MIN) {
+            c_memmove(x->child + 1, x->child, x->n*c_sizeof(void*));
+            c_memmove(x->keys + 1, x->keys, (x->n - 1)*c_sizeof(_m_key));
+            x->child[0] = y->child[--y->n];
+            x->keys[0] = _c_MEMB(_min_key_)(x->child[1], height - 1);
+            ++x->n;
+            return c;
+        }
+        if (c < in->n - 1 && (y = (_b_inner*)in->child[c + 1])->n > MIN) {
+            x->keys[x->n - 1] = _c_MEMB(_min_key_)(y->child[0], height - 1);
+            x->child[x->n++] = y->child[0];
+            c_memmove(y->child, y->child + 1, (y->n - 1)*c_sizeof(void*));
+            c_memmove(y->keys, y->keys + 1, (y->n - 2)*c_sizeof(_m_key));
+            --y->n;
+            return c;
+        }
+        if (c > 0)
+            y = x, x = (_b_inner*)in->child[--c];
+        else
+            y = (_b_inner*)in->child[c + 1];
+        x->keys[x->n - 1] = _c_MEMB(_min_key_)(y->child[0], height - 1);
+        c_memcpy(x->keys + x->n, y->keys, (y->n - 1)*c_sizeof(_m_key));
+        c_memcpy(x->child + x->n, y->child, y->n*c_sizeof(void*));
+        x->n += y->n;
+        i_free(y, c_sizeof(_b_inner));
+    }
+    _c_MEMB(_remove_child_)(in, c + 1);
+    return c;
+}
+
+// The leaf which may hold rkey, and the path down to it.
+static _m_leaf*
+_c_MEMB(_find_path_)(const Self* self, const _m_keyraw* rkey, _b_path* path) {
+    void* node = self->root;
+    for (int h = 0; h < self->height; ++h) {
+        _b_inner* in = (_b_inner*)node;
+        path[h].node = in;
+        path[h].idx = _c_MEMB(_inner_child_)(in, rkey);
+        node = in->child[path[h].idx];
+    }
+    return (_m_leaf*)node;
+}
+
+// Remove values [i, j) from the leaf.
+static void
+_c_MEMB(_leaf_erase_)(Self* self, _m_leaf* leaf, const int i, const int j) {
+    for (int k = i; k < j; ++k)
+        _c_MEMB(_value_drop)(&leaf->values[k]);
+    c_memmove(leaf->values + i, leaf->values + j, (leaf->n - j)*c_sizeof(_m_value));
+    leaf->n -= j - i;
+    self->size -= j - i;
+}
+
+// After values were removed from the leaf at the end of path: rebalance bottom up, and
+// refresh the separators next to the path, as the smallest key under a child may have
+// been erased or moved.
+static void
+_c_MEMB(_erase_fixup_)(Self* self, const _b_path* path, _m_leaf* leaf) {
+    for (int h = self->height - 1; h >= 0; --h) {
+        _b_inner* in = path[h].node;
+        const int height = self->height - 1 - h;
+        const int c = _c_MEMB(_rebalance_)(self, in, path[h].idx, height);
+        if (c > 0) in->keys[c - 1] = _c_MEMB(_min_key_)(in->child[c], height);
+        if (c < in->n - 1) in->keys[c] = _c_MEMB(_min_key_)(in->child[c + 1], height);
+    }
+    if (self->height == 0) {
+        if (leaf->n == 0) {
+            i_free(leaf, c_sizeof(_m_leaf));
+            self->root = NULL;
+        }
+    } else if (((_b_inner*)self->root)->n == 1) {
+        _b_inner* root = (_b_inner*)self->root;
+        self->root = root->child[0];
+        --self->height;
+        i_free(root, c_sizeof(_b_inner));
+    }
+}
+
+STC_DEF int
+_c_MEMB(_erase)(Self* self, _m_keyraw rkey) {
+    _b_path path[_c_MEMB(_maxheight_)];
+    if (self->root == NULL) return 0;
+    _m_leaf* leaf = _c_MEMB(_find_path_)(self, &rkey, path);
+    const int i = _c_MEMB(_leaf_lower_)(leaf, &rkey);
+    if (i == leaf->n) return 0;
+    const _m_keyraw _raw = i_keytoraw(_i_keyref(&leaf->values[i]));
+    if (i_less((&rkey), (&_raw))) return 0;
+
+    _c_MEMB(_leaf_erase_)(self, leaf, i, i + 1);
+    _c_MEMB(_erase_fixup_)(self, path, leaf);
+    return 1;
+}
+
+STC_DEF _m_iter
+_c_MEMB(_erase_at)(Self* self, _m_iter it) {
+    _m_iter nx = it;
+    _c_MEMB(_next)(&nx);
+    if (nx.ref == NULL) {
+        _c_MEMB(_erase)(self, i_keytoraw(_i_keyref(it.ref)));
+        return nx;
+    }
+    const _m_key next = *_i_keyref(nx.ref); // shallow copy: stays valid while the key is in the tree
+    _c_MEMB(_erase)(self, i_keytoraw(_i_keyref(it.ref)));
+    return _c_MEMB(_lower_bound)(self, i_keytoraw((&next)));
+}
+
+// Erase the range one leaf at a time: the part of the range in a leaf is removed
+// in one go, and the path is rebalanced once per leaf.
+STC_DEF _m_iter
+_c_MEMB(_erase_range)(Self* self, _m_iter it1, _m_iter it2) {
+    _b_path path[_c_MEMB(_maxheight_)];
+    const bool to_end = it2.ref == NULL;
+    _m_key k2 = {0}; // shallow copy: the values move within and between leaves
+    _m_keyraw r2 = {0};
+    if (!to_end) k2 = *_i_keyref(it2.ref), r2 = i_keytoraw((&k2));
+
+    while (it1.ref != NULL) {
+        const _m_keyraw r1 = i_keytoraw(_i_keyref(it1.ref));
+        if (!to_end && !(i_less((&r1), (&r2)))) break;
+        _m_leaf* leaf = _c_MEMB(_find_path_)(self, &r1, path);
+        const int i = _c_MEMB(_leaf_lower_)(leaf, &r1);
+        const int j = to_end ? leaf->n : _c_MEMB(_leaf_lower_)(leaf, &r2);
+        _c_MEMB(_leaf_erase_)(self, leaf, i, j);
+
+        const _m_value* nx = i < leaf->n ? &leaf->values[i] :
+                             leaf->next ? &leaf->next->values[0] : NULL;
+        if (nx == NULL) {
+            _c_MEMB(_erase_fixup_)(self, path, leaf);
+            return _c_MEMB(_end)(self);
+        }
+        const _m_key next = *_i_keyref(nx); // shallow copy: stays valid while the key is in the tree
+        _c_MEMB(_erase_fixup_)(self, path, leaf);
+        it1 = _c_MEMB(_lower_bound)(self, i_keytoraw((&next)));
+    }
+    return it1;
+}
+
+#ifdef _i_is_map
+    STC_DEF _m_result
+    _c_MEMB(_insert_or_assign)(Self* self, _m_key _key, _m_mapped _mapped) {
+        _m_result _res = _c_MEMB(_insert_entry_)(self, i_keytoraw((&_key)));
+        _m_mapped* _mp = _res.ref ? &_res.ref->second : &_mapped;
+        if (_res.inserted)
+            _res.ref->first = _key;
+        else
+            { i_keydrop((&_key)); i_valdrop(_mp); }
+        *_mp = _mapped;
+        return _res;
+    }
+
+    #if !defined i_no_emplace
+    STC_DEF _m_result
+    _c_MEMB(_emplace_or_assign)(Self* self, _m_keyraw rkey, _m_rmapped rmapped) {
+        _m_result _res = _c_MEMB(_insert_entry_)(self, rkey);
+        if (_res.inserted)
+            _res.ref->first = i_keyfrom(rkey);
+        else {
+            if (_res.ref == NULL) return _res;
+            i_valdrop((&_res.ref->second));
+        }
+        _res.ref->second = i_valfrom(rmapped);
+        return _res;
+    }
+    #endif // !i_no_emplace
+#endif // !_i_is_map
+
+#if !defined i_no_emplace
+STC_DEF _m_result
+_c_MEMB(_emplace)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped)) {
+    _m_result res = _c_MEMB(_insert_entry_)(self, rkey);
+    if (res.inserted) {
+        *_i_keyref(res.ref) = i_keyfrom(rkey);
+        _i_MAP_ONLY(res.ref->second = i_valfrom(rmapped);)
+    }
+    return res;
+}
+#endif // i_no_emplace
+
+#if !defined i_no_clone
+static void _c_MEMB(_drop_r_)(Self* self, void* node, int height);
+
+// Returns NULL if out of memory, after freeing the nodes cloned so far.
+static void*
+_c_MEMB(_clone_r_)(Self* self, void* node, int height, _m_leaf** last) {
+    if (height == 0) {
+        _m_leaf *src = (_m_leaf*)node, *leaf = (_m_leaf*)i_malloc(c_sizeof(_m_leaf));
+        if (leaf == NULL) return NULL;
+        leaf->n = src->n;
+        leaf->next = NULL;
+        for (c_range(i, src->n))
+            leaf->values[i] = _c_MEMB(_value_clone)(src->values[i]);
+        if (*last) (*last)->next = leaf;
+        return *last = leaf;
+    }
+    _b_inner *src = (_b_inner*)node, *in = (_b_inner*)i_malloc(c_sizeof(_b_inner));
+    if (in == NULL) return NULL;
+    in->n = src->n;
+    for (c_range(j, src->n)) {
+        in->child[j] = _c_MEMB(_clone_r_)(self, src->child[j], height - 1, last);
+        if (in->child[j] == NULL) {
+            while (j--) _c_MEMB(_drop_r_)(self, in->child[j], height - 1);
+            i_free(in, c_sizeof(_b_inner));
+            return NULL;
+        }
+        if (j) in->keys[j - 1] = _c_MEMB(_min_key_)(in->child[j], height - 1);
+    }
+    return in;
+}
+
+// Returns an empty tree if out of memory.
+STC_DEF Self
+_c_MEMB(_clone)(Self tree) {
+    Self clone = tree; // keeps aux and allocator context
+    _m_leaf* last = NULL;
+    if (tree.root && (clone.root = _c_MEMB(_clone_r_)(&clone, tree.root, tree.height, &last)) == NULL)
+        clone.size = 0, clone.height = 0;
+    return clone;
+}
+#endif // !i_no_clone
+
+static void
+_c_MEMB(_drop_r_)(Self* self, void* node, int height) {
+    if (height == 0) {
+        _m_leaf* leaf = (_m_leaf*)node;
+        for (c_range(i, leaf->n))
+            _c_MEMB(_value_drop)(&leaf->values[i]);
+        i_free(leaf, c_sizeof(_m_leaf));
+    } else {
+        _b_inner* in = (_b_inner*)node;
+        for (c_range(j, in->n))
+            _c_MEMB(_drop_r_)(self, in->child[j], height - 1);
+        i_free(in, c_sizeof(_b_inner));
+    }
+}
+
+STC_DEF void
+_c_MEMB(_drop)(const Self* cself) {
+    Self* self = (Self*)cself;
+    if (self->root != NULL)
+        _c_MEMB(_drop_r_)(self, self->root, self->height);
+}
+
+#endif // i_implement
+#undef _b_LEAF_CAP
+#undef _b_INNER_CAP
+#undef _b_inner
+#undef _b_path
+#undef _m_leaf
+#undef _i_is_set
+#undef _i_is_map
+#undef _i_sorted
+#undef _i_keyref
+#undef _i_MAP_ONLY
+#undef _i_SET_ONLY
+#include "priv/linkage2.h"
+#include "priv/template2.h"
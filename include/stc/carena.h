@@ -0,0 +1,182 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+// carena: bump (arena) allocator. Allocations are carved sequentially out of
+// large blocks and are all released at once by carena_reset() or carena_drop().
+/*
+#include "stc/carena.h"
+
+#define i_type IVec, int
+#define i_allocator carena
+#define i_allocator_ctx  // IVec gets a member: carena* alloc
+#include "stc/vec.h"
+
+int main(void) {
+    carena arena = carena_init();
+    for (c_range(request, 100)) {
+        IVec vec = {.alloc=&arena};
+        for (c_range32(i, 1000))
+            IVec_push(&vec, i);    // no malloc after the first request
+        carena_reset(&arena);      // frees vec, no need for IVec_drop()
+    }
+    carena_drop(&arena);
+}
+*/
+#define i_header // external linkage by default. override with i_static.
+#include "priv/linkage.h"
+
+#ifndef STC_CARENA_H_INCLUDED
+#define STC_CARENA_H_INCLUDED
+#include "common.h"
+#include <stdlib.h>
+
+#ifndef carena_BLOCK_SIZE
+  #define carena_BLOCK_SIZE (1 << 16)
+#endif
+#define _carena_ALIGN (2*c_sizeof(void*)) // header size of a block
+
+struct carena_block { struct carena_block* next; isize size; };
+
+typedef struct carena {
+    struct carena_block* blocks; // current block first
+    char* top;
+    isize avail, block_size;
+} carena;
+
+STC_API void*   _carena_new_block(carena* self, isize size);
+STC_API void*   carena_realloc(carena* self, void* p, isize old_size, isize size);
+STC_API void    carena_reset(carena* self);
+STC_API void    carena_drop(carena* self);
+
+STC_INLINE carena carena_init(void) { carena a = {0}; return a; }
+
+STC_INLINE carena carena_with_capacity(isize block_size)
+    { carena a = {0}; a.block_size = block_size; return a; }
+
+STC_INLINE isize _carena_round(isize size)
+    { return (size + _carena_ALIGN - 1) & ~(_carena_ALIGN - 1); }
+
+// A NULL arena allocates from the heap; containers constructed by e.g.
+// with_capacity() or clone() of a heap container have no arena.
+STC_INLINE void* carena_malloc(carena* self, isize size) {
+    if (self == NULL)
+        return c_malloc(size);
+    size = _carena_round(size);
+    if (size > self->avail)
+        return _carena_new_block(self, size);
+    void* p = self->top;
+    self->top += size;
+    self->avail -= size;
+    return p;
+}
+
+STC_INLINE void* carena_calloc(carena* self, isize n, isize size) {
+    if (self == NULL)
+        return c_calloc(n, size);
+    void* p = carena_malloc(self, n*size);
+    return p ? c_memset(p, 0, n*size) : NULL;
+}
+
+// Memory is reclaimed by carena_reset(); only the latest allocation is given back here.
+STC_INLINE void carena_free(carena* self, void* p, isize size) {
+    if (self == NULL)
+        { c_free(p, size); return; }
+    size = _carena_round(size);
+    if (p != NULL && (char*)p + size == self->top)
+        self->top = (char*)p, self->avail += size;
+}
+
+#endif // STC_CARENA_H_INCLUDED
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+#if defined i_implement
+
+#ifndef STC_CARENA_C_INCLUDED
+#define STC_CARENA_C_INCLUDED
+
+STC_DEF void* _carena_new_block(carena* self, const isize size) {
+    const isize bsize = self->block_size ? _carena_round(self->block_size) : carena_BLOCK_SIZE;
+    const bool own = self->blocks != NULL && size > bsize/4; // don't waste the current block
+    const isize cap = own || size > bsize ? size : bsize;
+    struct carena_block* b = (struct carena_block*)c_malloc(_carena_ALIGN + cap);
+    if (b == NULL)
+        return NULL;
+    char* data = (char*)b + _carena_ALIGN;
+    b->size = cap;
+    if (own) { // keep as second block
+        b->next = self->blocks->next;
+        self->blocks->next = b;
+        return data;
+    }
+    b->next = self->blocks;
+    self->blocks = b;
+    self->top = data + size;
+    self->avail = cap - size;
+    return data;
+}
+
+STC_DEF void* carena_realloc(carena* self, void* p, const isize old_size, const isize size) {
+    if (self == NULL)
+        return c_realloc(p, old_size, size);
+    if (p == NULL)
+        return carena_malloc(self, size);
+    const isize olds = _carena_round(old_size), news = _carena_round(size);
+    if ((char*)p + olds == self->top && news - olds <= self->avail) { // latest: resize in place
+        self->top += news - olds;
+        self->avail -= news - olds;
+        return p;
+    }
+    if (news <= olds)
+        return p;
+    void* q = carena_malloc(self, size);
+    if (q != NULL)
+        c_memcpy(q, p, old_size);
+    return q;
+}
+
+STC_DEF void carena_reset(carena* self) {
+    struct carena_block* b = self->blocks;
+    if (b == NULL)
+        return;
+    while (b->next != NULL) {
+        struct carena_block* next = b->next->next;
+        c_free(b->next, _carena_ALIGN + b->next->size);
+        b->next = next;
+    }
+    self->top = (char*)b + _carena_ALIGN;
+    self->avail = b->size;
+}
+
+STC_DEF void carena_drop(carena* self) {
+    while (self->blocks != NULL) {
+        struct carena_block* next = self->blocks->next;
+        c_free(self->blocks, _carena_ALIGN + self->blocks->size);
+        self->blocks = next;
+    }
+    self->top = NULL;
+    self->avail = 0;
+}
+
+#endif // STC_CARENA_C_INCLUDED
+#endif // i_implement
+#include "priv/linkage2.h"
@@ -0,0 +1,271 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+// catom: interned strings. Each distinct string is stored once in a catompool, and is
+// referred to by a catom handle. Atoms compare equal by pointer, and their hash is
+// computed once, when the string is interned.
+/*
+#include "stc/catom.h"
+
+#define i_type HostCount, catom, int, c_keyclass // keyed on atoms: pointer compare, stored hash
+#include "stc/hmap.h"
+
+int main(void) {
+    catompool pool = catompool_init();
+    HostCount count = {0};
+    const char* hosts[] = {"example.com", "stc.dev", "example.com"};
+    for (c_range(i, 3)) {
+        catom host = catompool_intern(&pool, hosts[i]);
+        HostCount_insert(&count, host, 0).ref->second += 1;
+    }
+    catom host = catompool_find(&pool, "example.com");
+    printf("%s: %d\n", catom_str(host), *HostCount_at(&count, host));
+    HostCount_drop(&count);
+    catompool_drop(&pool); // drop after the containers holding its atoms
+}
+*/
+#define i_header // external linkage by default. override with i_static.
+#include "priv/linkage.h"
+
+#ifndef STC_CATOM_H_INCLUDED
+#define STC_CATOM_H_INCLUDED
+#include "common.h"
+#include "types.h"
+
+#ifndef catom_BLOCK_SIZE
+  #define catom_BLOCK_SIZE (1 << 16)
+#endif
+
+// Read-only. The string follows the node, zero-terminated.
+typedef struct catom_node {
+    size_t hash;
+    struct _Catompool* pool;
+    isize size;
+    isize refs; // < 0: lives until the pool is dropped
+} catom_node;
+
+typedef struct { catom_node* node; } catom; // node is NULL for the null atom
+
+typedef struct { struct _Catompool* data; } catompool;
+
+// Atoms in a pool made by catompool_init() (or zero-initialized) are never freed before
+// the pool is, and are allocated in blocks. catompool_init_refcounted() makes a pool where
+// each atom is freed when its last reference is dropped; catompool_intern() and catom_clone()
+// add a reference, catom_drop() removes one.
+STC_API catompool   catompool_init_refcounted(void);
+STC_API void        catompool_drop(catompool* self);
+STC_API catom       catompool_intern_sv(catompool* self, csview sv);
+STC_API catom       catompool_find_sv(const catompool* self, csview sv);
+STC_API isize       catompool_size(const catompool* self);
+STC_API void        _catom_release(catom_node* node);
+
+STC_INLINE catompool catompool_init(void) { catompool pool = {0}; return pool; }
+
+STC_INLINE catom catompool_intern(catompool* self, const char* str)
+    { return catompool_intern_sv(self, c_sv_2(str, c_strlen(str))); }
+
+// Returns the null atom if str is not interned. Does not add a reference.
+STC_INLINE catom catompool_find(const catompool* self, const char* str)
+    { return catompool_find_sv(self, c_sv_2(str, c_strlen(str))); }
+
+STC_INLINE bool catom_is_null(catom a) { return a.node == NULL; }
+
+STC_INLINE const char* catom_str(catom a)
+    { return a.node ? (const char*)(a.node + 1) : ""; }
+
+STC_INLINE isize catom_size(catom a)
+    { return a.node ? a.node->size : 0; }
+
+STC_INLINE csview catom_sv(catom a)
+    { return c_sv_2(catom_str(a), catom_size(a)); }
+
+// Same as csview_hash() and cstr_hash() of the string.
+STC_INLINE size_t catom_hash(const catom* self)
+    { return self->node ? self->node->hash : c_basehash_n("", 0); }
+
+STC_INLINE bool catom_eq(const catom* x, const catom* y)
+    { return x->node == y->node; }
+
+// Orders by string content, e.g. for smap/sset.
+STC_INLINE int catom_cmp(const catom* x, const catom* y)
+    { return x->node == y->node ? 0 : strcmp(catom_str(*x), catom_str(*y)); }
+
+STC_INLINE catom catom_clone(catom a) {
+    if (a.node && a.node->refs > 0) ++a.node->refs;
+    return a;
+}
+
+STC_INLINE void catom_drop(const catom* self) {
+    if (self->node && self->node->refs > 0 && --self->node->refs == 0)
+        _catom_release(self->node);
+}
+
+#endif // STC_CATOM_H_INCLUDED
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+#if defined i_implement
+
+#ifndef STC_CATOM_C_INCLUDED
+#define STC_CATOM_C_INCLUDED
+
+typedef struct { csview sv; size_t hash; } _catom_raw;
+
+STC_INLINE _catom_raw _catom_toraw(catom_node* const* np)
+    { return c_literal(_catom_raw){{(const char*)(*np + 1), (*np)->size}, (*np)->hash}; }
+
+// The pool set: lookups are by string and stored hash, so growing it does not rehash strings.
+#define i_type _catompool_set, catom_node*
+#define i_keyraw _catom_raw
+#define i_keytoraw _catom_toraw
+#define i_hash(rp) (rp)->hash
+#define i_eq(x, y) ((x)->hash == (y)->hash && (x)->sv.size == (y)->sv.size && \
+                    !c_memcmp((x)->sv.buf, (y)->sv.buf, (x)->sv.size))
+#define i_keyfrom(rkey) NULL // unused: nodes are added by catompool_intern_sv()
+#define i_no_clone
+#define i_static
+#include "hset.h"
+#undef STC_DEF // restore linkage of the definitions below, declared by STC_API above
+#define STC_DEF
+
+struct _catom_block { struct _catom_block* next; isize size; };
+
+struct _Catompool {
+    _catompool_set set;
+    struct _catom_block* blocks; // current block first
+    char* top;
+    isize avail;
+    bool refcounted;
+};
+
+static struct _Catompool* _catompool_new(bool refcounted) {
+    struct _Catompool* p = (struct _Catompool*)c_calloc(1, c_sizeof *p);
+    if (p != NULL) p->refcounted = refcounted;
+    return p;
+}
+
+// Atoms of a non-refcounted pool are carved out of large blocks.
+static catom_node* _catompool_alloc(struct _Catompool* p, isize size) {
+    if (p->refcounted)
+        return (catom_node*)c_malloc(size);
+    size = (size + c_sizeof(size_t) - 1) & ~(c_sizeof(size_t) - 1);
+    if (size <= p->avail) {
+        char* node = p->top;
+        p->top += size, p->avail -= size;
+        return (catom_node*)node;
+    }
+    const bool own = size > catom_BLOCK_SIZE/4; // don't waste the current block
+    const isize cap = own ? size : catom_BLOCK_SIZE;
+    struct _catom_block* b = (struct _catom_block*)c_malloc(c_sizeof *b + cap);
+    if (b == NULL)
+        return NULL;
+    char* data = (char*)(b + 1);
+    b->size = cap;
+    if (own && p->blocks != NULL) { // keep as second block
+        b->next = p->blocks->next;
+        p->blocks->next = b;
+        return (catom_node*)data;
+    }
+    b->next = p->blocks;
+    p->blocks = b;
+    p->top = data + size;
+    p->avail = cap - size;
+    return (catom_node*)data;
+}
+
+STC_DEF catompool catompool_init_refcounted(void) {
+    catompool pool = {_catompool_new(true)};
+    return pool;
+}
+
+STC_DEF void catompool_drop(catompool* self) {
+    struct _Catompool* p = self->data;
+    if (p == NULL)
+        return;
+    if (p->refcounted) {
+        for (c_each(i, _catompool_set, p->set))
+            c_free(*i.ref, c_sizeof(catom_node) + (*i.ref)->size + 1);
+    }
+    while (p->blocks != NULL) {
+        struct _catom_block* next = p->blocks->next;
+        c_free(p->blocks, c_sizeof *p->blocks + p->blocks->size);
+        p->blocks = next;
+    }
+    _catompool_set_drop(&p->set);
+    c_free(p, c_sizeof *p);
+    self->data = NULL;
+}
+
+STC_DEF catom catompool_intern_sv(catompool* self, csview sv) {
+    catom atom = {NULL};
+    if (self->data == NULL && (self->data = _catompool_new(false)) == NULL)
+        return atom;
+    struct _Catompool* p = self->data;
+    const _catom_raw raw = {sv, c_basehash_n(sv.buf, sv.size)};
+    _catompool_set_result res = _catompool_set_insert_entry_(&p->set, raw);
+    if (res.ref == NULL)
+        return atom;
+    if (res.inserted) {
+        catom_node* node = _catompool_alloc(p, c_sizeof(catom_node) + sv.size + 1);
+        if (node == NULL) {
+            _catompool_set_erase_entry(&p->set, res.ref);
+            return atom;
+        }
+        node->hash = raw.hash;
+        node->pool = p;
+        node->size = sv.size;
+        node->refs = p->refcounted ? 0 : -1;
+        c_memcpy(node + 1, sv.buf, sv.size);
+        ((char*)(node + 1))[sv.size] = '\0';
+        *res.ref = node;
+    }
+    atom.node = *res.ref;
+    atom.node->refs += atom.node->refs >= 0;
+    return atom;
+}
+
+STC_DEF catom catompool_find_sv(const catompool* self, csview sv) {
+    catom atom = {NULL};
+    if (self->data != NULL) {
+        const _catom_raw raw = {sv, c_basehash_n(sv.buf, sv.size)};
+        catom_node* const* ref = _catompool_set_get(&self->data->set, raw);
+        if (ref != NULL)
+            atom.node = *ref;
+    }
+    return atom;
+}
+
+STC_DEF isize catompool_size(const catompool* self) {
+    return self->data ? _catompool_set_size(&self->data->set) : 0;
+}
+
+STC_DEF void _catom_release(catom_node* node) {
+    struct _Catompool* p = node->pool;
+    catom_node** ref = _catompool_set_get_mut(&p->set, _catom_toraw(&node));
+    c_assert(ref != NULL && *ref == node);
+    _catompool_set_erase_entry(&p->set, ref);
+    c_free(node, c_sizeof(catom_node) + node->size + 1);
+}
+
+#endif // STC_CATOM_C_INCLUDED
+#endif // i_implement
+#include "priv/linkage2.h"
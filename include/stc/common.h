@@ -25,6 +25,7 @@
 
 #ifdef _MSC_VER
     #pragma warning(disable: 4116 4996) // unnamed type definition in parentheses
+    #include <intrin.h>
 #endif
 #include <inttypes.h>
 #include <stddef.h>
@@ -47,10 +48,20 @@ typedef ptrdiff_t       isize;
     defined __GNUC__ || defined __clang__ || defined __TINYC__)
     #define STC_HAS_TYPEOF 1
 #endif
+// C11 <threads.h> is used by the parallel sort, the coroutine executor and sync_map.
+// Define STC_NO_THREADS to disable it.
+#if !defined STC_HAS_THREADS && !defined STC_NO_THREADS && !defined __STDC_NO_THREADS__ \
+                             && defined __has_include
+    #if __has_include(<threads.h>)
+        #define STC_HAS_THREADS
+    #endif
+#endif
 #if defined __GNUC__ || defined __clang__
     #define STC_INLINE static inline __attribute((unused))
+    #define c_prefetch(p) __builtin_prefetch(p)
 #else
     #define STC_INLINE static inline
+    #define c_prefetch(p) ((void)(p))
 #endif
 #define c_ZI PRIiPTR
 #define c_ZU PRIuPTR
@@ -255,7 +266,84 @@ typedef const char* cstr_raw;
 STC_INLINE void* c_safe_memcpy(void* dst, const void* src, isize size)
     { return dst ? memcpy(dst, src, (size_t)size) : NULL; }
 
+// 64x64 => 128 bit multiply: *a = low half, *b = high half
+STC_INLINE void _c_mum(uint64_t* a, uint64_t* b) {
+  #if defined __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r, *b = (uint64_t)(r >> 64);
+  #elif defined _MSC_VER && defined _M_X64
+    *a = _umul128(*a, *b, b);
+  #else
+    const uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    const uint64_t rh = ha*hb, rm0 = ha*lb, rm1 = hb*la, rl = la*lb;
+    const uint64_t t = rl + (rm0 << 32), lo = t + (rm1 << 32);
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl) + (lo < t);
+    *a = lo;
+  #endif
+}
+
+STC_INLINE uint64_t _c_mum_mix(uint64_t a, uint64_t b)
+    { _c_mum(&a, &b); return a ^ b; }
+
+STC_INLINE uint64_t _c_read64(const uint8_t* p)
+    { uint64_t v; memcpy(&v, p, 8); return v; }
+
+STC_INLINE uint64_t _c_read32(const uint8_t* p)
+    { uint32_t v; memcpy(&v, p, 4); return v; }
+
+// Seeded 64-bit hash of the wyhash family, after rapidhash (MIT) by Nicolas De Carli.
+// Long keys are consumed 48 bytes at a time in three independent multiply chains.
+STC_INLINE uint64_t c_hash_seed_n(const void* key, isize len, uint64_t seed) {
+    static const uint64_t s[3] = {0x2d358dccaa6c78a5, 0x8bb84b93962eacc9, 0x4b33a62ed433d4a3};
+    const uint8_t* p = (const uint8_t*)key;
+    const uint64_t n = (uint64_t)len;
+    uint64_t a, b;
+    seed ^= _c_mum_mix(seed ^ s[0], s[1]) ^ n;
+
+    if (n <= 16) {
+        if (n >= 4) {
+            const uint8_t* plast = p + n - 4;
+            const uint64_t delta = (n & 24) >> (n >> 3);
+            a = (_c_read32(p) << 32) | _c_read32(plast);
+            b = (_c_read32(p + delta) << 32) | _c_read32(plast - delta);
+        } else if (n > 0) {
+            a = ((uint64_t)p[0] << 56) | ((uint64_t)p[n >> 1] << 32) | p[n - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        uint64_t i = n;
+        if (i > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = _c_mum_mix(_c_read64(p) ^ s[0], _c_read64(p + 8) ^ seed);
+                see1 = _c_mum_mix(_c_read64(p + 16) ^ s[1], _c_read64(p + 24) ^ see1);
+                see2 = _c_mum_mix(_c_read64(p + 32) ^ s[2], _c_read64(p + 40) ^ see2);
+                p += 48, i -= 48;
+            } while (i >= 48);
+            seed ^= see1 ^ see2;
+        }
+        if (i > 16) {
+            seed = _c_mum_mix(_c_read64(p) ^ s[2], _c_read64(p + 8) ^ seed ^ s[1]);
+            if (i > 32)
+                seed = _c_mum_mix(_c_read64(p + 16) ^ s[2], _c_read64(p + 24) ^ seed);
+        }
+        a = _c_read64(p + i - 16);
+        b = _c_read64(p + i - 8);
+    }
+    a ^= s[1], b ^= seed;
+    _c_mum(&a, &b);
+    return _c_mum_mix(a ^ s[0] ^ n, b ^ s[1]);
+}
+
+// Define STC_HASH_SEED (for the whole build, including the stc library) to make
+// c_hash_seed_n() the default hash function of all types, e.g. -DSTC_HASH_SEED=0x1234.
+// It may name a variable, which lets a program pick a random seed at startup.
 STC_INLINE size_t c_basehash_n(const void* key, isize len) {
+  #ifdef STC_HASH_SEED
+    return (size_t)c_hash_seed_n(key, len, (uint64_t)(STC_HASH_SEED));
+  #else
     size_t block = 0, hash = 0x811c9dc5;
     const uint8_t* msg = (const uint8_t*)key;
     while (len > c_sizeof(size_t)) {
@@ -266,14 +354,24 @@ STC_INLINE size_t c_basehash_n(const void* key, isize len) {
     }
     c_memcpy(&block, msg, len);
     hash = (hash ^ block) * (size_t)0xb0340f4501000193;
-    return hash ^ (hash >> 3);
+    // the multiplies only move bits upward: fold the high half down and remix
+    hash = (hash ^ (hash >> (sizeof(size_t)*4))) * (size_t)0xc6a4a7935bd1e99d;
+    return hash ^ (hash >> (sizeof(size_t)*4 - 3));
+  #endif
 }
 
 STC_INLINE size_t c_hash_n(const void* key, isize len) {
     uint64_t b8; uint32_t b4;
     switch (len) {
+      #ifdef STC_HASH_SEED
+        case 8: memcpy(&b8, key, 8);
+                return (size_t)_c_mum_mix(b8 ^ (uint64_t)(STC_HASH_SEED) ^ 0x2d358dccaa6c78a5, 0x8bb84b93962eacc9);
+        case 4: memcpy(&b4, key, 4);
+                return (size_t)_c_mum_mix(b4 ^ (uint64_t)(STC_HASH_SEED) ^ 0x2d358dccaa6c78a5, 0x8bb84b93962eacc9);
+      #else
         case 8: memcpy(&b8, key, 8); return (size_t)(b8 * 0xc6a4a7935bd1e99d);
         case 4: memcpy(&b4, key, 4); return b4 * (size_t)0xa2ffeb2f01000193;
+      #endif
         default: return c_basehash_n(key, len);
     }
 }
@@ -311,15 +409,88 @@ STC_INLINE isize c_next_pow2(isize n) {
     return n + 1;
 }
 
+// index of lowest set bit, x must be non-zero
+STC_INLINE int c_trailing_zeros(uint64_t x) {
+    #if defined __GNUC__ || defined __clang__
+    return __builtin_ctzll(x);
+    #elif defined _MSC_VER && defined _WIN64
+    unsigned long i; _BitScanForward64(&i, x);
+    return (int)i;
+    #else
+    int n = 0;
+    while (!(x & 1)) x >>= 1, ++n;
+    return n;
+    #endif
+}
+
+// Substring search prefilter: scan for windows where the needle bytes at offsets i1 and
+// i2 match, 16/32 windows per step with SIMD, and only memcmp those. Requires i1, i2 < nlen.
+#if defined __AVX2__
+  #include <immintrin.h>
+  #define _c_strstr_AVX2
+#elif defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define _c_strstr_SSE2
+#elif defined __ARM_NEON && defined __aarch64__
+  #include <arm_neon.h>
+  #define _c_strstr_NEON
+#endif
+
+STC_INLINE char* _c_strnstrn_pair(const char *str, isize slen, const char *needle, isize nlen,
+                                  isize i1, isize i2) {
+    const char* end = str + slen - nlen + 1; // one past the last window
+  #if defined _c_strstr_AVX2
+    const __m256i c1 = _mm256_set1_epi8(needle[i1]), c2 = _mm256_set1_epi8(needle[i2]);
+    for (; end - str >= 32; str += 32) {
+        const __m256i b1 = _mm256_loadu_si256((const __m256i*)(str + i1));
+        const __m256i b2 = _mm256_loadu_si256((const __m256i*)(str + i2));
+        uint32_t m = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(b1, c1),
+                                                                     _mm256_cmpeq_epi8(b2, c2)));
+        for (; m; m &= m - 1) {
+            const char* s = str + c_trailing_zeros(m);
+            if (!c_memcmp(s, needle, nlen)) return (char *)s;
+        }
+    }
+  #elif defined _c_strstr_SSE2
+    const __m128i c1 = _mm_set1_epi8(needle[i1]), c2 = _mm_set1_epi8(needle[i2]);
+    for (; end - str >= 16; str += 16) {
+        const __m128i b1 = _mm_loadu_si128((const __m128i*)(str + i1));
+        const __m128i b2 = _mm_loadu_si128((const __m128i*)(str + i2));
+        uint32_t m = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(b1, c1),
+                                                               _mm_cmpeq_epi8(b2, c2)));
+        for (; m; m &= m - 1) {
+            const char* s = str + c_trailing_zeros(m);
+            if (!c_memcmp(s, needle, nlen)) return (char *)s;
+        }
+    }
+  #elif defined _c_strstr_NEON
+    const uint8x16_t c1 = vdupq_n_u8((uint8_t)needle[i1]), c2 = vdupq_n_u8((uint8_t)needle[i2]);
+    for (; end - str >= 16; str += 16) {
+        const uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8((const uint8_t*)str + i1), c1),
+                                       vceqq_u8(vld1q_u8((const uint8_t*)str + i2), c2));
+        // 4 bits per byte
+        uint64_t m = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        for (m &= 0x8888888888888888ULL; m; m &= m - 1) {
+            const char* s = str + (c_trailing_zeros(m) >> 2);
+            if (!c_memcmp(s, needle, nlen)) return (char *)s;
+        }
+    }
+  #endif
+    while (str < end) {
+        const char* s = (const char*)memchr(str + i1, needle[i1], (size_t)(end - str));
+        if (s == NULL) break;
+        s -= i1;
+        if (s[i2] == needle[i2] && !c_memcmp(s, needle, nlen))
+            return (char *)s;
+        str = s + 1;
+    }
+    return NULL;
+}
+
 STC_INLINE char* c_strnstrn(const char *str, isize slen, const char *needle, isize nlen) {
     if (nlen == 0) return (char *)str;
     if (nlen > slen) return NULL;
-    slen -= nlen;
-    do {
-        if (*str == *needle && !c_memcmp(str, needle, nlen))
-            return (char *)str;
-        ++str;
-    } while (slen--);
-    return NULL;
+    if (nlen == 1) return (char *)memchr(str, *needle, (size_t)slen);
+    return _c_strnstrn_pair(str, slen, needle, nlen, 0, nlen - 1);
 }
 #endif // STC_COMMON_H_INCLUDED
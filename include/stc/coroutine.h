@@ -58,6 +58,7 @@ int main(void) {
 */
 #include <stdlib.h>
 #include "common.h"
+#include "priv/atomic_prv.h"
 
 enum {
     CCO_STATE_INIT = 0,
@@ -181,6 +182,10 @@ typedef struct cco_fiber {
     int recover_state, awaitbits, result;
     int error, error_line;
     cco_state cco;
+    struct cco_executor* exec; /* set when run by a cco_executor */
+    struct cco_fiber* spawner;
+    catomic_isize refs;        /* 1 + fibers spawned from this one still alive */
+    int worker;
 } cco_fiber, cco_runtime; /* cco_runtime [deprecated] */
 
 /* Define a Task struct */
@@ -261,14 +266,35 @@ static inline int _cco_cancel_task(cco_task* task, cco_fiber* fiber)
 #define cco_run_task_2(task, env) cco_run_fiber_2(_it_fb, cco_new_fiber_2(task, env))
 #define cco_run_task_3(it_fiber, task, env) cco_run_fiber_2(it_fiber, cco_new_fiber_2(task, env))
 
-static inline bool cco_is_joined(const cco_fiber* fiber)
-    { return fiber == fiber->next; }
+/* On an executor: true when all fibers spawned from fiber (recursively) are finished */
+static inline bool cco_is_joined(const cco_fiber* fiber) {
+    return fiber->exec ? c_atomic_load_acquire((catomic_isize*)&fiber->refs) == 1
+                       : fiber == fiber->next;
+}
 
 extern cco_fiber* _cco_new_fiber(cco_task* task, void* env);
 extern cco_fiber* _cco_spawn(cco_task* task, cco_fiber* fb, void* env);
 extern cco_fiber* cco_resume_next(cco_fiber* prev);
 extern int        cco_resume_current(cco_fiber* co); /* coroutine */
 
+/*
+ * cco_executor: run fibers on a pool of worker threads. Each worker owns a deque of
+ * ready fibers, and idle workers steal half the fibers of a busy one. A fiber runs on
+ * one worker at a time, but may resume on another worker after it has suspended.
+ * cco_spawn() called from a fiber on the executor pushes the new fiber to the current
+ * worker's deque, and cco_await(cco_is_joined(fb)) awaits the spawned fibers.
+ */
+typedef struct cco_executor cco_executor;
+
+#define cco_executor_spawn(...) c_MACRO_OVERLOAD(cco_executor_spawn, __VA_ARGS__)
+#define cco_executor_spawn_2(exec, task) cco_executor_spawn_3(exec, task, NULL)
+#define cco_executor_spawn_3(exec, task, env) _cco_executor_spawn(exec, cco_cast_task(task), env)
+
+extern cco_executor* cco_new_executor(int nworkers);
+extern void       cco_drop_executor(cco_executor* exec);
+extern cco_fiber* _cco_executor_spawn(cco_executor* exec, cco_task* task, void* env);
+extern void       cco_run_executor(cco_executor* exec);
+
 /* -------------------------- IMPLEMENTATION ------------------------- */
 #if defined i_implement || defined STC_IMPLEMENT
 #include <stdio.h>
@@ -320,14 +346,265 @@ cco_fiber* _cco_new_fiber(cco_task* _task, void* env) {
     return (new_fb->next = new_fb);
 }
 
+static cco_fiber* _cco_executor_spawn_from(cco_executor* exec, cco_task* task,
+                                           cco_fiber* spawner, void* env);
+
 cco_fiber* _cco_spawn(cco_task* _task, cco_fiber* fb, void* env) {
     cco_fiber* new_fb;
+    if (fb->exec != NULL)
+        return _cco_executor_spawn_from(fb->exec, _task, fb, env == NULL ? fb->env : env);
     new_fb = fb->next = (fb->next == NULL ? fb : c_new(cco_fiber, {.next=fb->next}));
     new_fb->task = _task;
     new_fb->env = (env == NULL ? fb->env : env);
     return new_fb;
 }
 
+
+/* cco_executor implementation */
+
+#ifdef STC_HAS_THREADS
+  #include <threads.h>
+  #define _cco_lock(m) mtx_lock(m)
+  #define _cco_unlock(m) mtx_unlock(m)
+#else
+  #define _cco_lock(m) (void)0
+  #define _cco_unlock(m) (void)0
+#endif
+
+struct _cco_worker {
+    cco_fiber** buf;    /* ring buffer of ready fibers, owner pops the front */
+    isize head, cap;
+    catomic_isize size; /* read unlocked by thieves */
+    cco_executor* exec;
+    uint64_t seed;
+  #ifdef STC_HAS_THREADS
+    mtx_t mtx;
+    thrd_t thread;
+  #endif
+    char _pad[64];
+};
+
+struct cco_executor {
+    catomic_isize live;  /* fibers not yet freed */
+    catomic_isize nidle; /* workers waiting on cnd */
+    int nworkers, next;
+  #ifdef STC_HAS_THREADS
+    mtx_t mtx;
+    cnd_t cnd;
+  #endif
+    struct _cco_worker* worker;
+};
+
+static void _cco_wake(cco_executor* exec, bool all) {
+  #ifdef STC_HAS_THREADS
+    if (c_atomic_load_acquire(&exec->nidle) > 0) {
+        mtx_lock(&exec->mtx);
+        all ? cnd_broadcast(&exec->cnd) : cnd_signal(&exec->cnd);
+        mtx_unlock(&exec->mtx);
+    }
+  #else
+    (void)exec; (void)all;
+  #endif
+}
+
+static void _cco_push(struct _cco_worker* w, cco_fiber** fbs, isize n) {
+    _cco_lock(&w->mtx);
+    isize size = c_atomic_load_relaxed(&w->size);
+    if (size + n > w->cap) {
+        isize cap = w->cap ? w->cap*2 : 64;
+        while (cap < size + n) cap *= 2;
+        cco_fiber** buf = (cco_fiber**)c_malloc(cap*c_sizeof *buf);
+        if (buf == NULL) {
+            fprintf(stderr, __FILE__ ":%d: error: cco_executor out of memory.\n", __LINE__);
+            exit(1);
+        }
+        for (isize i = 0; i < size; ++i)
+            buf[i] = w->buf[(w->head + i) & (w->cap - 1)];
+        c_free(w->buf, w->cap*c_sizeof *buf);
+        w->buf = buf, w->head = 0, w->cap = cap;
+    }
+    for (isize i = 0; i < n; ++i)
+        w->buf[(w->head + size + i) & (w->cap - 1)] = fbs[i];
+    c_atomic_store_relaxed(&w->size, size + n);
+    _cco_unlock(&w->mtx);
+    _cco_wake(w->exec, false);
+}
+
+static cco_fiber* _cco_pop(struct _cco_worker* w) {
+    cco_fiber* fb = NULL;
+    if (c_atomic_load_relaxed(&w->size) == 0)
+        return NULL;
+    _cco_lock(&w->mtx);
+    isize size = c_atomic_load_relaxed(&w->size);
+    if (size > 0) {
+        fb = w->buf[w->head];
+        w->head = (w->head + 1) & (w->cap - 1);
+        c_atomic_store_relaxed(&w->size, size - 1);
+    }
+    _cco_unlock(&w->mtx);
+    return fb;
+}
+
+/* Take half the fibers from the back of a victim's deque, starting at a random one */
+static cco_fiber* _cco_steal(struct _cco_worker* w) {
+    enum {max_steal = 32};
+    cco_executor* exec = w->exec;
+    cco_fiber* fbs[max_steal];
+    isize n = 0;
+    w->seed = w->seed*6364136223846793005ULL + 1442695040888963407ULL;
+    int start = (int)((w->seed >> 33) % (uint64_t)exec->nworkers);
+
+    for (int k = 0; k < exec->nworkers && n == 0; ++k) {
+        struct _cco_worker* v = &exec->worker[(start + k) % exec->nworkers];
+        if (v == w || c_atomic_load_relaxed(&v->size) == 0)
+            continue;
+        _cco_lock(&v->mtx);
+        isize size = c_atomic_load_relaxed(&v->size);
+        n = (size + 1)/2;
+        if (n > max_steal) n = max_steal;
+        for (isize i = 0; i < n; ++i)
+            fbs[i] = v->buf[(v->head + size - n + i) & (v->cap - 1)];
+        c_atomic_store_relaxed(&v->size, size - n);
+        _cco_unlock(&v->mtx);
+    }
+    if (n > 1)
+        _cco_push(w, fbs + 1, n - 1);
+    return n ? fbs[0] : NULL;
+}
+
+/* Free a finished fiber once its spawned fibers are freed, then release its spawner */
+static void _cco_release(cco_executor* exec, cco_fiber* fb) {
+    while (fb != NULL && c_atomic_fetch_sub(&fb->refs, 1) == 1) {
+        cco_fiber* spawner = fb->spawner;
+        free(fb);
+        if (c_atomic_fetch_sub(&exec->live, 1) == 1)
+            _cco_wake(exec, true);
+        fb = spawner;
+    }
+}
+
+static void _cco_idle(cco_executor* exec, int rounds) {
+  #ifdef STC_HAS_THREADS
+    if (rounds < 64) {
+        thrd_yield();
+        return;
+    }
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    ts.tv_nsec += 1000000; /* wait at most 1 ms, in case a wakeup was missed */
+    if (ts.tv_nsec >= 1000000000) ts.tv_sec += 1, ts.tv_nsec -= 1000000000;
+    mtx_lock(&exec->mtx);
+    c_atomic_fetch_add(&exec->nidle, 1);
+    if (c_atomic_load_acquire(&exec->live) > 0)
+        cnd_timedwait(&exec->cnd, &exec->mtx, &ts);
+    c_atomic_fetch_sub(&exec->nidle, 1);
+    mtx_unlock(&exec->mtx);
+  #else
+    (void)exec; (void)rounds;
+  #endif
+}
+
+static int _cco_worker_run(void* arg) {
+    struct _cco_worker* w = (struct _cco_worker*)arg;
+    cco_executor* exec = w->exec;
+    const int id = (int)(w - exec->worker);
+    int idle = 0;
+
+    while (c_atomic_load_acquire(&exec->live) > 0) {
+        cco_fiber* fb = _cco_pop(w);
+        if (fb == NULL && (fb = _cco_steal(w)) == NULL) {
+            _cco_idle(exec, ++idle);
+            continue;
+        }
+        idle = 0;
+        fb->worker = id;
+        if (cco_resume_current(fb) == CCO_DONE)
+            _cco_release(exec, fb);
+        else
+            _cco_push(w, &fb, 1);
+    }
+    return 0;
+}
+
+cco_executor* cco_new_executor(int nworkers) {
+  #ifndef STC_HAS_THREADS
+    nworkers = 1;
+  #endif
+    if (nworkers < 1) nworkers = 1;
+    cco_executor* exec = (cco_executor*)c_calloc(1, c_sizeof(cco_executor) +
+                                                    nworkers*c_sizeof(struct _cco_worker));
+    if (exec == NULL) return NULL;
+    exec->worker = (struct _cco_worker*)(exec + 1);
+    exec->nworkers = nworkers;
+  #ifdef STC_HAS_THREADS
+    mtx_init(&exec->mtx, mtx_plain);
+    cnd_init(&exec->cnd);
+  #endif
+    for (int i = 0; i < nworkers; ++i) {
+        exec->worker[i].exec = exec;
+        exec->worker[i].seed = (uint64_t)i*0x9e3779b97f4a7c15ULL + 1;
+      #ifdef STC_HAS_THREADS
+        mtx_init(&exec->worker[i].mtx, mtx_plain);
+      #endif
+    }
+    return exec;
+}
+
+/* Frees fibers that were never run. Their tasks are owned by the caller. */
+void cco_drop_executor(cco_executor* exec) {
+    if (exec == NULL) return;
+    for (int i = 0; i < exec->nworkers; ++i) {
+        struct _cco_worker* w = &exec->worker[i];
+        cco_fiber* fb;
+        while ((fb = _cco_pop(w)) != NULL)
+            free(fb);
+        c_free(w->buf, w->cap*c_sizeof *w->buf);
+      #ifdef STC_HAS_THREADS
+        mtx_destroy(&w->mtx);
+      #endif
+    }
+  #ifdef STC_HAS_THREADS
+    cnd_destroy(&exec->cnd);
+    mtx_destroy(&exec->mtx);
+  #endif
+    free(exec);
+}
+
+static cco_fiber* _cco_executor_spawn_from(cco_executor* exec, cco_task* task,
+                                           cco_fiber* spawner, void* env) {
+    cco_fiber* fb = c_new(cco_fiber, {.task=task, .env=env, .exec=exec, .spawner=spawner});
+    if (fb == NULL) return NULL;
+    c_atomic_store_relaxed(&fb->refs, 1);
+    if (spawner != NULL)
+        c_atomic_fetch_add(&spawner->refs, 1);
+    c_atomic_fetch_add(&exec->live, 1);
+    /* from inside a fiber: run on the current worker; else round-robin */
+    int i = spawner ? spawner->worker : exec->next++ % exec->nworkers;
+    _cco_push(&exec->worker[i], &fb, 1);
+    return fb;
+}
+
+/* Spawn a root fiber. Call before cco_run_executor(), or from the thread running it. */
+cco_fiber* _cco_executor_spawn(cco_executor* exec, cco_task* task, void* env) {
+    return _cco_executor_spawn_from(exec, task, NULL, env);
+}
+
+/* Run all fibers, using the calling thread as worker 0. Returns when all are finished. */
+void cco_run_executor(cco_executor* exec) {
+  #ifdef STC_HAS_THREADS
+    int n = 1;
+    while (n < exec->nworkers && thrd_create(&exec->worker[n].thread, _cco_worker_run,
+                                             &exec->worker[n]) == thrd_success)
+        ++n; /* on failure, the running workers steal the fibers left on the others */
+    _cco_worker_run(&exec->worker[0]);
+    while (--n > 0)
+        thrd_join(exec->worker[n].thread, NULL);
+  #else
+    _cco_worker_run(&exec->worker[0]);
+  #endif
+}
+#undef _cco_lock
+#undef _cco_unlock
 #undef i_implement
 #endif
 
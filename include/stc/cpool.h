@@ -0,0 +1,158 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+// cpool: size-class pool allocator. Requests up to cpool_MAXSIZE bytes are rounded up
+// to a power of two and served from a free list per size class, so freed nodes and
+// buffers are recycled without calling malloc. Larger requests go to the heap.
+/*
+#include "stc/cpool.h"
+
+#define i_type IList, int
+#define i_allocator cpool
+#define i_allocator_ctx  // IList gets a member: cpool* alloc
+#include "stc/list.h"
+
+int main(void) {
+    cpool pool = cpool_init();
+    IList list = {.alloc=&pool};
+    for (c_range32(i, 100000))
+        IList_push_back(&list, i);
+    IList_drop(&list);   // nodes are returned to the pool
+    cpool_drop(&pool);   // memory is returned to the system
+}
+*/
+#define i_header // external linkage by default. override with i_static.
+#include "priv/linkage.h"
+
+#ifndef STC_CPOOL_H_INCLUDED
+#define STC_CPOOL_H_INCLUDED
+#include "common.h"
+#include <stdlib.h>
+
+#define cpool_CLASSES 8 // 16, 32, .., 2048 bytes
+#define cpool_MAXSIZE (16 << (cpool_CLASSES - 1))
+#ifndef cpool_SLAB_SIZE
+  #define cpool_SLAB_SIZE (1 << 16)
+#endif
+#define _cpool_HEADER 16 // slab header, keeps objects 16 byte aligned
+
+typedef struct cpool {
+    void* freelist[cpool_CLASSES];
+    struct cpool_slab* slabs;
+} cpool;
+
+STC_API void*   _cpool_refill(cpool* self, int k);
+STC_API void*   cpool_realloc(cpool* self, void* p, isize old_size, isize size);
+STC_API void    cpool_drop(cpool* self);
+
+STC_INLINE cpool cpool_init(void) { cpool p = {0}; return p; }
+
+STC_INLINE int _cpool_class(isize size)
+    { return size <= 16 ? 0 : c_trailing_zeros((uint64_t)c_next_pow2(size)) - 4; }
+
+// A NULL pool allocates from the heap; containers constructed by e.g.
+// with_capacity() or clone() of a heap container have no pool.
+STC_INLINE void* cpool_malloc(cpool* self, isize size) {
+    if (self == NULL || size > cpool_MAXSIZE)
+        return c_malloc(size);
+    const int k = _cpool_class(size);
+    void** p = (void**)self->freelist[k];
+    if (p == NULL)
+        return _cpool_refill(self, k);
+    self->freelist[k] = *p;
+    return p;
+}
+
+STC_INLINE void* cpool_calloc(cpool* self, isize n, isize size) {
+    if (self == NULL)
+        return c_calloc(n, size);
+    void* p = cpool_malloc(self, n*size);
+    return p ? c_memset(p, 0, n*size) : NULL;
+}
+
+STC_INLINE void cpool_free(cpool* self, void* p, isize size) {
+    if (self == NULL || size > cpool_MAXSIZE)
+        { c_free(p, size); return; }
+    if (p != NULL) {
+        const int k = _cpool_class(size);
+        *(void**)p = self->freelist[k];
+        self->freelist[k] = p;
+    }
+}
+
+#endif // STC_CPOOL_H_INCLUDED
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+#if defined i_implement
+
+#ifndef STC_CPOOL_C_INCLUDED
+#define STC_CPOOL_C_INCLUDED
+
+struct cpool_slab { struct cpool_slab* next; };
+
+// Carve a new slab into objects of class k: return the first, put the rest on the free list.
+STC_DEF void* _cpool_refill(cpool* self, const int k) {
+    struct cpool_slab* slab = (struct cpool_slab*)c_malloc(cpool_SLAB_SIZE);
+    if (slab == NULL)
+        return NULL;
+    slab->next = self->slabs;
+    self->slabs = slab;
+
+    const isize objsize = 16 << k;
+    char* first = (char*)slab + _cpool_HEADER;
+    for (isize i = (cpool_SLAB_SIZE - _cpool_HEADER)/objsize - 1; i > 0; --i) {
+        void** p = (void**)(first + i*objsize);
+        *p = self->freelist[k];
+        self->freelist[k] = p;
+    }
+    return first;
+}
+
+STC_DEF void* cpool_realloc(cpool* self, void* p, const isize old_size, const isize size) {
+    if (self == NULL || (old_size > cpool_MAXSIZE && size > cpool_MAXSIZE))
+        return c_realloc(p, old_size, size);
+    if (p == NULL)
+        return cpool_malloc(self, size);
+    if (old_size <= cpool_MAXSIZE && size <= cpool_MAXSIZE &&
+        _cpool_class(old_size) == _cpool_class(size))
+        return p;
+    void* q = cpool_malloc(self, size);
+    if (q != NULL) {
+        c_memcpy(q, p, old_size < size ? old_size : size);
+        cpool_free(self, p, old_size);
+    }
+    return q;
+}
+
+STC_DEF void cpool_drop(cpool* self) {
+    while (self->slabs != NULL) {
+        struct cpool_slab* next = self->slabs->next;
+        c_free(self->slabs, cpool_SLAB_SIZE);
+        self->slabs = next;
+    }
+    c_memset(self->freelist, 0, c_sizeof self->freelist);
+}
+
+#endif // STC_CPOOL_C_INCLUDED
+#endif // i_implement
+#include "priv/linkage2.h"
@@ -32,6 +32,7 @@ THE SOFTWARE.
  */
 #include "common.h"
 #include "types.h" // csview, cstr types
+#include <stdio.h> // FILE*
 
 enum {
     CREG_DEFAULT = 0,
@@ -75,6 +76,20 @@ typedef struct {
     int error;
 } cregex;
 
+/* a set of regexes matched together in one pass over the input */
+typedef struct {
+    cregex* regex;
+    int count;
+    struct _Reprog* prog;
+    int error;
+} cregex_set;
+
+/* matches a regex against input that arrives in chunks, e.g. blocks read from a file */
+typedef struct {
+    const cregex* regex;
+    struct _Restream* state;
+} cregex_stream;
+
 typedef struct {
     const cregex* regex;
     csview input;
@@ -164,6 +179,62 @@ STC_INLINE cstr cregex_replace_aio(const char* pattern, const char* input, const
 /* destroy regex */
 void cregex_drop(cregex* re);
 
+
+/* compile n patterns into a regex set. return CREG_OK, or negative error code on failure.
+ * on failure, cregex_set_get(set, i)->error tells which pattern was in error. */
+int cregex_set_compile(cregex_set* set, const char* patterns[], int n, int cflags);
+
+STC_INLINE cregex_set cregex_set_make(const char* patterns[], int n, int cflags) {
+    cregex_set set = {0};
+    cregex_set_compile(&set, patterns, n, cflags);
+    return set;
+}
+
+/* number of patterns in the set */
+STC_INLINE int cregex_set_size(const cregex_set* set)
+    { return set->count; }
+
+/* the compiled regex of pattern i, e.g. to get match positions and captures */
+STC_INLINE const cregex* cregex_set_get(const cregex_set* set, int i)
+    { return &set->regex[i]; }
+
+/* set matched[i] for each pattern i that matches input. return number of matching patterns,
+ * or CREG_MATCHERROR. */
+int cregex_set_match(const cregex_set* set, const char* input, bool matched[]);
+int cregex_set_match_sv(const cregex_set* set, csview input, bool matched[]);
+
+/* destroy regex set */
+void cregex_set_drop(cregex_set* set);
+
+
+/* create a stream matcher for re. re must outlive the stream */
+STC_INLINE cregex_stream cregex_stream_init(const cregex* re) {
+    cregex_stream st = {re, NULL};
+    return st;
+}
+
+/* append a chunk of input. invalidates the matches returned so far.
+ * return CREG_OK, or CREG_OUTOFMEMORY. */
+int cregex_stream_feed(cregex_stream* st, csview chunk);
+
+/* mark end of input, so that e.g. $ and \b may match at the end. */
+int cregex_stream_close(cregex_stream* st);
+
+/* get the next match in the input so far. matches may span chunks, and positions are
+ * retained until the next feed. return CREG_OK, CREG_NOMATCH if more input is needed
+ * (or the stream is closed and done), or CREG_MATCHERROR. */
+int cregex_stream_next(cregex_stream* st, csview match[]);
+
+/* like cregex_stream_next(), but feeds blocks read from fp as needed, and closes
+ * the stream at end of file. */
+int cregex_stream_next_file(cregex_stream* st, FILE* fp, csview match[]);
+
+/* stream offset of pos, which must be within a match returned by the stream */
+isize cregex_stream_offset(const cregex_stream* st, const char* pos);
+
+/* destroy stream matcher */
+void cregex_stream_drop(cregex_stream* st);
+
 #endif // STC_CREGEX_H_INCLUDED
 
 #if defined STC_IMPLEMENT || defined i_implement || defined i_import
@@ -0,0 +1,268 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+// crope: chunked string builder. The content is a sequence of pieces (views) into
+// chunks owned by the rope, or into external memory. Appending never moves earlier
+// content, and inserting splits a piece instead of moving bytes.
+/*
+#include <sys/uio.h>
+#include "stc/crope.h"
+
+void respond(int fd, const char* body) {
+    crope r = crope_init();
+    crope_append(&r, "HTTP/1.1 200 OK\r\n");
+    crope_append_fmt(&r, "Content-Length: %d\r\n\r\n", (int)strlen(body));
+    crope_append_ref(&r, c_sv(body, strlen(body))); // not copied
+    struct iovec iov[16];
+    isize n = crope_piece_count(&r);
+    for (c_range(i, n))
+        iov[i] = (struct iovec){(void*)crope_pieces(&r)[i].buf, (size_t)crope_pieces(&r)[i].size};
+    writev(fd, iov, (int)n);
+    crope_drop(&r);
+}
+*/
+#define i_header // external linkage by default. override with i_static.
+#include "priv/linkage.h"
+
+#ifndef STC_CROPE_H_INCLUDED
+#define STC_CROPE_H_INCLUDED
+#include "common.h"
+#include "types.h"
+#include "priv/utf8_prv.h"
+#include "priv/cstr_prv.h"
+
+#ifndef crope_CHUNK_SIZE
+  #define crope_CHUNK_SIZE (1 << 12) // grows with the rope, up to 256 times this
+#endif
+
+typedef struct crope {
+    csview* pieces;
+    isize count, capacity;      // number of pieces
+    isize size;                 // bytes
+    struct crope_chunk* chunks; // newest first
+    char* top;                  // free space of the newest chunk
+    isize avail;
+} crope;
+
+STC_API void    crope_drop(crope* self);
+STC_API void    crope_clear(crope* self);
+STC_API void    crope_append_n(crope* self, const char* str, isize len);
+STC_API isize   crope_append_fmt(crope* self, const char* fmt, ...);
+STC_API void    crope_append_ref(crope* self, csview sv);
+STC_API void    crope_insert_sv(crope* self, isize pos, csview sv);
+STC_API void    crope_insert_ref(crope* self, isize pos, csview sv);
+STC_API isize   crope_copy(const crope* self, isize pos, char* dst, isize n);
+
+STC_INLINE crope crope_init(void) { crope r = {0}; return r; }
+STC_INLINE isize crope_size(const crope* self) { return self->size; }
+STC_INLINE bool crope_is_empty(const crope* self) { return self->size == 0; }
+
+// The content as views in order, e.g. for writev().
+STC_INLINE isize crope_piece_count(const crope* self) { return self->count; }
+STC_INLINE const csview* crope_pieces(const crope* self) { return self->pieces; }
+
+STC_INLINE void crope_append(crope* self, const char* str)
+    { crope_append_n(self, str, c_strlen(str)); }
+
+STC_INLINE void crope_append_sv(crope* self, csview sv)
+    { crope_append_n(self, sv.buf, sv.size); }
+
+STC_INLINE void crope_insert(crope* self, isize pos, const char* str)
+    { crope_insert_sv(self, pos, c_sv_2(str, c_strlen(str))); }
+
+STC_INLINE cstr crope_to_cstr(const crope* self) {
+    cstr s = cstr_with_capacity(self->size);
+    crope_copy(self, 0, cstr_data(&s), self->size);
+    _cstr_set_size(&s, self->size);
+    return s;
+}
+
+#endif // STC_CROPE_H_INCLUDED
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+#if defined i_implement
+
+#ifndef STC_CROPE_C_INCLUDED
+#define STC_CROPE_C_INCLUDED
+#include <stdarg.h>
+
+struct crope_chunk { struct crope_chunk* next; isize size; };
+
+// Makes room for at least n contiguous bytes at top, in a new chunk if needed.
+static bool _crope_reserve(crope* self, const isize n) {
+    if (n <= self->avail)
+        return true;
+    isize cap = self->size < crope_CHUNK_SIZE ? crope_CHUNK_SIZE :
+                self->size > crope_CHUNK_SIZE*256 ? crope_CHUNK_SIZE*256 : self->size;
+    if (cap < n) cap = n;
+    struct crope_chunk* c = (struct crope_chunk*)c_malloc(c_sizeof *c + cap);
+    if (c == NULL)
+        return false;
+    c->next = self->chunks, c->size = cap;
+    self->chunks = c;
+    self->top = (char*)(c + 1), self->avail = cap;
+    return true;
+}
+
+static csview* _crope_new_pieces(crope* self, const isize idx, const isize n) {
+    if (self->count + n > self->capacity) {
+        const isize cap = self->capacity*3/2 + 8 + n;
+        csview* p = (csview*)c_realloc(self->pieces, self->capacity*c_sizeof *p, cap*c_sizeof *p);
+        if (p == NULL)
+            return NULL;
+        self->pieces = p, self->capacity = cap;
+    }
+    c_memmove(self->pieces + idx + n, self->pieces + idx, (self->count - idx)*c_sizeof(csview));
+    self->count += n;
+    return self->pieces + idx;
+}
+
+// Adds sv as the last piece, or extends the last piece when sv follows it in memory.
+static void _crope_push(crope* self, const csview sv) {
+    csview* last = self->count ? &self->pieces[self->count - 1] : NULL;
+    if (last && last->buf + last->size == sv.buf)
+        last->size += sv.size;
+    else if ((last = _crope_new_pieces(self, self->count, 1)) != NULL)
+        *last = sv;
+    else
+        return;
+    self->size += sv.size;
+}
+
+STC_DEF void crope_drop(crope* self) {
+    while (self->chunks != NULL) {
+        struct crope_chunk* next = self->chunks->next;
+        c_free(self->chunks, c_sizeof *self->chunks + self->chunks->size);
+        self->chunks = next;
+    }
+    c_free(self->pieces, self->capacity*c_sizeof *self->pieces);
+    *self = crope_init();
+}
+
+// Keeps the newest (largest) chunk and the piece array for reuse.
+STC_DEF void crope_clear(crope* self) {
+    struct crope_chunk* c = self->chunks;
+    if (c != NULL) {
+        while (c->next != NULL) {
+            struct crope_chunk* next = c->next->next;
+            c_free(c->next, c_sizeof *c + c->next->size);
+            c->next = next;
+        }
+        self->top = (char*)(c + 1), self->avail = c->size;
+    }
+    self->count = self->size = 0;
+}
+
+STC_DEF void crope_append_n(crope* self, const char* str, isize len) {
+    while (len > 0) {
+        if (self->avail == 0 && !_crope_reserve(self, len))
+            return;
+        const isize n = len < self->avail ? len : self->avail;
+        c_memcpy(self->top, str, n);
+        _crope_push(self, c_sv_2(self->top, n));
+        self->top += n, self->avail -= n;
+        str += n, len -= n;
+    }
+}
+
+STC_DEF isize crope_append_fmt(crope* self, const char* fmt, ...) {
+    va_list args, args2;
+    va_start(args, fmt);
+    va_copy(args2, args);
+    isize n = vsnprintf(self->top, (size_t)self->avail, fmt, args);
+    if (n >= self->avail) { // did not fit: format again in a new chunk
+        if (_crope_reserve(self, n + 1))
+            vsnprintf(self->top, (size_t)n + 1, fmt, args2);
+        else
+            n = 0;
+    }
+    va_end(args2);
+    va_end(args);
+    if (n > 0) { // the terminating nul is overwritten by the next append
+        _crope_push(self, c_sv_2(self->top, n));
+        self->top += n, self->avail -= n;
+    }
+    return n;
+}
+
+STC_DEF void crope_append_ref(crope* self, const csview sv) {
+    if (sv.size == 0)
+        return;
+    csview* p = _crope_new_pieces(self, self->count, 1);
+    if (p == NULL)
+        return;
+    *p = sv;
+    self->size += sv.size;
+}
+
+STC_DEF void crope_insert_ref(crope* self, const isize pos, const csview sv) {
+    c_assert(0 <= pos && pos <= self->size);
+    if (pos == self->size) {
+        crope_append_ref(self, sv);
+        return;
+    }
+    if (sv.size == 0)
+        return;
+    isize i = 0, off = pos;
+    while (off >= self->pieces[i].size)
+        off -= self->pieces[i++].size;
+    if (off == 0) {
+        if (_crope_new_pieces(self, i, 1) == NULL)
+            return;
+        self->pieces[i] = sv;
+    } else { // split piece i around the new piece
+        if (_crope_new_pieces(self, i + 1, 2) == NULL)
+            return;
+        csview* p = &self->pieces[i];
+        p[2] = c_sv_2(p[0].buf + off, p[0].size - off);
+        p[1] = sv;
+        p[0].size = off;
+    }
+    self->size += sv.size;
+}
+
+STC_DEF void crope_insert_sv(crope* self, const isize pos, const csview sv) {
+    if (sv.size == 0 || !_crope_reserve(self, sv.size))
+        return;
+    c_memcpy(self->top, sv.buf, sv.size);
+    crope_insert_ref(self, pos, c_sv_2(self->top, sv.size));
+    self->top += sv.size, self->avail -= sv.size;
+}
+
+// Copies up to n bytes from byte position pos into dst. Returns number of bytes copied.
+STC_DEF isize crope_copy(const crope* self, isize pos, char* dst, const isize n) {
+    isize i = 0, done = 0;
+    while (i < self->count && pos >= self->pieces[i].size)
+        pos -= self->pieces[i++].size;
+    for (; i < self->count && done < n; ++i, pos = 0) {
+        isize k = self->pieces[i].size - pos;
+        if (k > n - done) k = n - done;
+        c_memcpy(dst + done, self->pieces[i].buf + pos, k);
+        done += k;
+    }
+    return done;
+}
+
+#endif // STC_CROPE_C_INCLUDED
+#endif // i_implement
+#include "priv/linkage2.h"
@@ -0,0 +1,194 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+// csnap: read-only snapshot files of containers with POD keys and values. A snapshot
+// holds the container's arrays as they are in memory, and is opened with mmap, so a
+// container view can be used directly on the mapped pages without deserializing.
+// Containers get write_snapshot() and view_snapshot() when defined with i_snapshot.
+// A view uses the mapped pages directly: it must not be modified or dropped, and it is
+// valid until the snapshot is closed.
+/*
+#define i_type Index, int, double
+#define i_snapshot
+#include "stc/hmap.h"
+
+void save(const Index* index) {
+    Index_write_snapshot(index, "index.snap");
+}
+
+double lookup(int key) {
+    csnap snap = csnap_open("index.snap");
+    Index index;
+    double value = 0.0;
+    if (Index_view_snapshot(&index, &snap) && Index_contains(&index, key))
+        value = *Index_at(&index, key);
+    csnap_close(&snap); // the view is invalid after this
+    return value;
+}
+*/
+#ifndef STC_CSNAP_H_INCLUDED
+#define STC_CSNAP_H_INCLUDED
+#include "common.h"
+#include <stdio.h>
+#if defined _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#define csnap_VERSION 1
+#define csnap_SECTIONS 4
+#define csnap_ALIGN 64 // file offset alignment of the sections
+enum { csnap_VEC = 1, csnap_HMAP = 2, csnap_SMAP = 3 };
+
+typedef struct csnap_header {
+    char magic[8];              // "STCSNAP"
+    uint32_t version, endian;   // endian is 0x01020304 as written
+    uint32_t kind, flags;       // container kind and layout options
+    uint64_t key_size, value_size, count;
+    uint64_t param[4];          // container specific, e.g. the bucket count
+    uint64_t offset[csnap_SECTIONS], bytes[csnap_SECTIONS]; // from the start of the file
+} csnap_header;
+
+typedef struct csnap {
+    const csnap_header* hdr;    // NULL when not open
+    isize size;                 // file size
+} csnap;
+
+// Writes hdr and the sections with hdr.bytes[i] bytes each to path. The file is written
+// as path.tmp, and then renamed to path, so that processes which have an older snapshot
+// at path mapped keep a valid view of it.
+STC_INLINE bool csnap_write(const char* path, csnap_header hdr, const void* const section[csnap_SECTIONS]) {
+    static const char pad[csnap_ALIGN] = {0};
+    const isize len = c_strlen(path);
+    char* tmp = (char*)c_malloc(len + 5);
+    if (tmp == NULL)
+        return false;
+    c_memcpy(tmp, path, len);
+    c_memcpy(tmp + len, ".tmp", 5);
+    c_memcpy(hdr.magic, "STCSNAP", 8);
+    hdr.version = csnap_VERSION, hdr.endian = 0x01020304;
+
+    uint64_t pos = sizeof hdr;
+    for (c_range(i, csnap_SECTIONS)) {
+        pos = (pos + csnap_ALIGN - 1) & ~(uint64_t)(csnap_ALIGN - 1);
+        hdr.offset[i] = hdr.bytes[i] ? pos : 0;
+        pos += hdr.bytes[i];
+    }
+    FILE* fp = fopen(tmp, "wb");
+    bool ok = fp != NULL && fwrite(&hdr, sizeof hdr, 1, fp) == 1;
+    pos = sizeof hdr;
+    for (c_range(i, csnap_SECTIONS)) if (ok && hdr.bytes[i]) {
+        const size_t gap = (size_t)(hdr.offset[i] - pos), n = (size_t)hdr.bytes[i];
+        ok = fwrite(pad, 1, gap, fp) == gap && fwrite(section[i], 1, n, fp) == n;
+        pos = hdr.offset[i] + hdr.bytes[i];
+    }
+    if (fp != NULL)
+        ok = (fclose(fp) == 0) && ok;
+    #if defined _WIN32
+    if (ok) remove(path); // rename() does not replace files on windows
+    #endif
+    if (ok) ok = rename(tmp, path) == 0;
+    if (!ok) remove(tmp);
+    c_free(tmp, len + 5);
+    return ok;
+}
+
+STC_INLINE void csnap_close(csnap* self) {
+    if (self->hdr != NULL) {
+        #if defined _WIN32
+        UnmapViewOfFile(self->hdr);
+        #else
+        munmap((void*)self->hdr, (size_t)self->size);
+        #endif
+    }
+    self->hdr = NULL, self->size = 0;
+}
+
+// Maps the snapshot file at path read-only. Pages are loaded on first access, and are
+// shared by all processes which map the same file. hdr is NULL if the file could not be
+// mapped or is not a valid snapshot.
+STC_INLINE csnap csnap_open(const char* path) {
+    csnap snap = {NULL, 0};
+    void* base = NULL;
+    #if defined _WIN32
+    HANDLE fh = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER fsize;
+    if (fh == INVALID_HANDLE_VALUE)
+        return snap;
+    if (GetFileSizeEx(fh, &fsize) && fsize.QuadPart >= (LONGLONG)sizeof(csnap_header)) {
+        HANDLE mh = CreateFileMappingA(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mh != NULL) {
+            base = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mh);
+            snap.size = (isize)fsize.QuadPart;
+        }
+    }
+    CloseHandle(fh);
+    #else
+    struct stat st;
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return snap;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(csnap_header)) {
+        base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) base = NULL;
+        snap.size = (isize)st.st_size;
+    }
+    close(fd);
+    #endif
+    if ((snap.hdr = (const csnap_header*)base) == NULL)
+        return snap;
+
+    const csnap_header* h = snap.hdr;
+    bool ok = !c_memcmp(h->magic, "STCSNAP", 8) && h->version == csnap_VERSION &&
+              h->endian == 0x01020304;
+    for (c_range(i, csnap_SECTIONS))
+        ok = ok && h->offset[i] % csnap_ALIGN == 0 && h->bytes[i] <= (uint64_t)snap.size &&
+             h->offset[i] <= (uint64_t)snap.size - h->bytes[i];
+    if (!ok)
+        csnap_close(&snap);
+    return snap;
+}
+
+STC_INLINE bool csnap_is_open(const csnap* self)
+    { return self->hdr != NULL; }
+
+STC_INLINE const void* csnap_section(const csnap* self, const int i)
+    { return self->hdr->bytes[i] ? (const char*)self->hdr + self->hdr->offset[i] : NULL; }
+
+// The header, if the snapshot holds a container of the given kind and layout, else NULL.
+STC_INLINE const csnap_header* csnap_check(const csnap* self, const uint32_t kind, const uint32_t flags,
+                                           const isize key_size, const isize value_size) {
+    const csnap_header* h = self->hdr;
+    if (h == NULL || h->kind != kind || h->flags != flags ||
+        h->key_size != (uint64_t)key_size || h->value_size != (uint64_t)value_size)
+        return NULL;
+    return h;
+}
+
+#endif // STC_CSNAP_H_INCLUDED
@@ -40,6 +40,11 @@ csview              csview_u8_subview(csview sv, isize u8pos, isize u8len);
 csview              csview_u8_tail(csview sv, isize u8len);
 csview_iter         csview_u8_at(csview sv, isize u8pos);
 
+/* Precompiled needle for repeated searches: the SIMD prefilter is keyed on the two
+   needle bytes least likely to occur in text, instead of the first and last byte. */
+typedef struct { csview needle; isize i1, i2; } csview_searcher;
+csview_searcher     csview_searcher_from(csview needle);
+
 STC_INLINE csview   csview_from(const char* str)
     { return c_literal(csview){str, c_strlen(str)}; }
 STC_INLINE csview   csview_from_n(const char* str, isize n)
@@ -69,6 +74,16 @@ STC_INLINE isize csview_find(csview sv, const char* str)
 STC_INLINE bool csview_contains(csview sv, const char* str)
     { return csview_find(sv, str) != c_NPOS; }
 
+STC_INLINE isize csview_searcher_find(const csview_searcher* self, csview sv) {
+    const isize n = self->needle.size;
+    const char* res = n < 2 || n > sv.size ? c_strnstrn(sv.buf, sv.size, self->needle.buf, n)
+                    : _c_strnstrn_pair(sv.buf, sv.size, self->needle.buf, n, self->i1, self->i2);
+    return res ? (res - sv.buf) : c_NPOS;
+}
+
+STC_INLINE bool csview_searcher_contains(const csview_searcher* self, csview sv)
+    { return csview_searcher_find(self, sv) != c_NPOS; }
+
 STC_INLINE bool csview_starts_with(csview sv, const char* str) {
     isize n = c_strlen(str);
     return n <= sv.size && !c_memcmp(sv.buf, str, n);
@@ -212,6 +227,33 @@ csview csview_token(csview sv, const char* sep, isize* pos) {
     return tok;
 }
 
+// Rough frequency class of a byte in text and logs: 3 = very common, 0 = rare.
+static int _csview_byte_class(uint8_t c) {
+    if (c >= 'a' && c <= 'z') return strchr("etaoinsrl", c) ? 3 : 2;
+    if (c >= '0' && c <= '9') return c <= '2' ? 3 : 2;
+    if (c == ' ') return 3;
+    if (c >= 'A' && c <= 'Z') return 1;
+    return (c > ' ' && c < 127) ? (strchr("/.:=-_,", c) ? 2 : 1) : 0;
+}
+
+csview_searcher csview_searcher_from(csview needle) {
+    csview_searcher s = {needle, 0, needle.size - 1};
+    int best = 4;
+    for (isize i = 0; i < needle.size; ++i) {
+        int k = _csview_byte_class((uint8_t)needle.buf[i]);
+        if (k < best) best = k, s.i1 = i;
+    }
+    // second byte: rarest one differing from the first, preferably far from it
+    best = 4;
+    for (isize i = 0; i < needle.size; ++i) {
+        if (needle.buf[i] == needle.buf[s.i1]) continue;
+        int k = _csview_byte_class((uint8_t)needle.buf[i]);
+        isize d = i > s.i1 ? i - s.i1 : s.i1 - i, dbest = s.i2 > s.i1 ? s.i2 - s.i1 : s.i1 - s.i2;
+        if (k < best || (k == best && d > dbest)) best = k, s.i2 = i;
+    }
+    return s;
+}
+
 csview csview_u8_subview(csview sv, isize u8pos, isize u8len) {
     const char* s, *end = &sv.buf[sv.size];
     while ((u8pos > 0) & (sv.buf != end))
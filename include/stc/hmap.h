@@ -55,8 +55,93 @@ int main(void) {
 #define _hashmask 0x3fU
 #define _distmask 0x3ffU
 struct hmap_meta { uint16_t hashx:6, dist:10; }; // dist: 0=empty, 1=PSL 0, 2=PSL 1, ...
+#define _hmap_BATCH 16 // keys hashed and prefetched ahead in the _n lookups
+#define hmap_STATS_BINS 16
+#define hmap_DIST_WARN (_distmask/2) // the PSL limit is _distmask - 1
+
+typedef struct hmap_stats {
+    isize size, bucket_count;
+    float load_factor;
+    float avg_dist;         // average probe sequence length (PSL): 0 if in its home bucket
+    isize max_dist;         // longest PSL
+    isize dist_hist[hmap_STATS_BINS]; // entries per PSL, the last bin counts all longer PSLs
+    isize table_bytes, meta_bytes;
+    isize extra_bytes;      // hash array, and the old table while rehashing
+    isize rehashes;         // with i_stats: number of table rebuilds, else -1
+    isize peak_dist;        // with i_stats: longest PSL since creation, else -1
+    bool dist_warning;      // a PSL reached hmap_DIST_WARN: the hash function is likely bad
+} hmap_stats;
 #endif // STC_HMAP_H_INCLUDED
 
+#if defined i_simd_probe && !defined STC_HMAP_SIMD_INCLUDED
+#define STC_HMAP_SIMD_INCLUDED
+// Group probing: compare the meta entries of _hmap_GROUP consecutive buckets in one go.
+// Returns one bit per bucket whose hashx and dist equal the probe sequence {hashx, dist+k}.
+// *stop gets one bit per bucket where a robin-hood lookup terminates (meta dist < dist+k).
+#if defined __AVX2__
+  #include <immintrin.h>
+  #define _hmap_AVX2
+  #define _hmap_GROUP 16
+#elif defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define _hmap_SSE2
+  #define _hmap_GROUP 8
+#elif defined __ARM_NEON && defined __aarch64__
+  #include <arm_neon.h>
+  #define _hmap_NEON
+  #define _hmap_GROUP 8
+#endif
+
+#ifdef _hmap_GROUP
+STC_INLINE uint16_t _hmap_meta_bits(struct hmap_meta m)
+    { uint16_t u; memcpy(&u, &m, sizeof u); return u; }
+
+STC_INLINE uint32_t _hmap_group_probe(const struct hmap_meta* meta, uint8_t hashx,
+                                      uint16_t dist, uint32_t* stop) {
+    const short base = (short)_hmap_meta_bits(c_literal(struct hmap_meta){
+                       .hashx=(uint16_t)(hashx & _hashmask), .dist=(uint16_t)(dist & _distmask)});
+    const short one = (short)_hmap_meta_bits(c_literal(struct hmap_meta){.dist=1});
+    const short dmask = (short)_hmap_meta_bits(c_literal(struct hmap_meta){.dist=_distmask});
+  #if defined _hmap_AVX2
+    const __m256i m = _mm256_loadu_si256((const __m256i*)meta);
+    const __m256i t = _mm256_add_epi16(_mm256_set1_epi16(base), _mm256_mullo_epi16(_mm256_set1_epi16(one),
+                      _mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)));
+    const __m256i dm = _mm256_set1_epi16(dmask), zero = _mm256_setzero_si256();
+    const __m256i eq = _mm256_cmpeq_epi16(m, t);
+    const __m256i ge = _mm256_cmpeq_epi16(_mm256_subs_epu16(_mm256_and_si256(t, dm),
+                                                            _mm256_and_si256(m, dm)), zero);
+    #define _hmap_MOVEMASK(v) (uint32_t)(_mm256_movemask_epi8( \
+                _mm256_permute4x64_epi64(_mm256_packs_epi16(v, v), 0xD8)) & 0xffff)
+    *stop = ~_hmap_MOVEMASK(ge) & 0xffff;
+    return _hmap_MOVEMASK(eq);
+  #elif defined _hmap_SSE2
+    const __m128i m = _mm_loadu_si128((const __m128i*)meta);
+    const __m128i t = _mm_add_epi16(_mm_set1_epi16(base), _mm_mullo_epi16(_mm_set1_epi16(one),
+                      _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7)));
+    const __m128i dm = _mm_set1_epi16(dmask), zero = _mm_setzero_si128();
+    const __m128i eq = _mm_cmpeq_epi16(m, t);
+    const __m128i ge = _mm_cmpeq_epi16(_mm_subs_epu16(_mm_and_si128(t, dm),
+                                                      _mm_and_si128(m, dm)), zero);
+    #define _hmap_MOVEMASK(v) (uint32_t)(_mm_movemask_epi8(_mm_packs_epi16(v, v)) & 0xff)
+    *stop = ~_hmap_MOVEMASK(ge) & 0xff;
+    return _hmap_MOVEMASK(eq);
+  #elif defined _hmap_NEON
+    static const uint16_t iota[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    static const uint8_t bit[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+    const uint16x8_t m = vld1q_u16((const uint16_t*)meta);
+    const uint16x8_t t = vaddq_u16(vdupq_n_u16((uint16_t)base), vmulq_n_u16(vld1q_u16(iota), (uint16_t)one));
+    const uint16x8_t dm = vdupq_n_u16((uint16_t)dmask);
+    const uint16x8_t eq = vceqq_u16(m, t);
+    const uint16x8_t lt = vcltq_u16(vandq_u16(m, dm), vandq_u16(t, dm));
+    #define _hmap_MOVEMASK(v) (uint32_t)vaddv_u8(vand_u8(vmovn_u16(v), vld1_u8(bit)))
+    *stop = _hmap_MOVEMASK(lt);
+    return _hmap_MOVEMASK(eq);
+  #endif
+    #undef _hmap_MOVEMASK
+}
+#endif // _hmap_GROUP
+#endif // i_simd_probe
+
 #ifndef _i_prefix
   #define _i_prefix hmap_
 #endif
@@ -72,6 +157,22 @@ struct hmap_meta { uint16_t hashx:6, dist:10; }; // dist: 0=empty, 1=PSL 0, 2=PS
 #endif
 #define _i_is_hash
 #include "priv/template.h"
+#ifdef i_snapshot
+  #include "csnap.h"
+#endif
+#if defined i_store_hash && defined i_incremental_rehash
+  #error "i_store_hash and i_incremental_rehash cannot be combined"
+#endif
+#if defined i_snapshot && defined i_incremental_rehash
+  #error "i_snapshot and i_incremental_rehash cannot be combined"
+#endif
+#ifdef i_store_hash // 32 bits of the hash are stored per bucket
+  #define _i_hash_match(self, i, hash) ((self)->hashes[i] == (uint32_t)(hash))
+  #define _i_stored_hash(self, i, rkeyptr) ((size_t)(self)->hashes[i])
+#else
+  #define _i_hash_match(self, i, hash) ((void)(hash), true)
+  #define _i_stored_hash(self, i, rkeyptr) i_hash(rkeyptr)
+#endif
 #ifndef i_declared
   _c_DEFTYPES(_c_htable_types, Self, i_key, i_val, _i_MAP_ONLY, _i_SET_ONLY);
 #endif
@@ -98,32 +199,106 @@ STC_API bool            _c_MEMB(_reserve)(Self* self, isize capacity);
 STC_API void            _c_MEMB(_erase_entry)(Self* self, _m_value* val);
 STC_API float           _c_MEMB(_max_load_factor)(const Self* self);
 STC_API isize           _c_MEMB(_capacity)(const Self* map);
-static _m_result        _c_MEMB(_bucket_lookup_)(const Self* self, const _m_keyraw* rkeyptr);
-static _m_result        _c_MEMB(_bucket_insert_)(const Self* self, const _m_keyraw* rkeyptr);
+static _m_result        _c_MEMB(_bucket_lookup_hashed_)(const Self* self, const _m_keyraw* rkeyptr, size_t hash);
+static _m_result        _c_MEMB(_bucket_insert_hashed_)(const Self* self, const _m_keyraw* rkeyptr, size_t hash);
+STC_API isize           _c_MEMB(_get_n)(const Self* self, const _m_keyraw* rkeys, isize n, const _m_value** out);
+STC_API isize           _c_MEMB(_contains_n)(const Self* self, const _m_keyraw* rkeys, isize n, bool* out);
+STC_API hmap_stats      _c_MEMB(_stats)(const Self* self);
+#ifdef i_snapshot
+STC_API bool            _c_MEMB(_write_snapshot)(const Self* self, const char* path);
+STC_API bool            _c_MEMB(_view_snapshot)(Self* view, const csnap* snap);
+#endif
+#ifdef i_incremental_rehash
+static bool             _c_MEMB(_grow_)(Self* self, isize capacity);
+static _m_result        _c_MEMB(_rehash_step_)(Self* self, const _m_keyraw* rkeyptr, size_t hash);
+static void             _c_MEMB(_rehash_all_)(Self* self);
+
+// The table being migrated, viewed as a map of its own.
+STC_INLINE Self _c_MEMB(_old_)(const Self* self) {
+    Self old = *self;
+    old.table = self->_old.table, old.meta = self->_old.meta;
+    old.bucket_count = self->_old.bucket_count;
+    c_memset(&old._old, 0, c_sizeof old._old);
+    return old;
+}
+
+STC_INLINE bool _c_MEMB(_in_old_)(const Self* self, const _m_value* ref) {
+    return (uintptr_t)ref - (uintptr_t)self->_old.table <
+           (uintptr_t)self->_old.bucket_count*sizeof *ref;
+}
+
+// Mutable lookups and erase also advance a pending rehash. The const
+// lookups never modify the map, so they stay safe for concurrent readers.
+STC_INLINE void _c_MEMB(_migrate_)(Self* self) {
+    if (self->_old.table != NULL)
+        _c_MEMB(_rehash_step_)(self, NULL, 0);
+}
+#endif
+
+STC_INLINE _m_result _c_MEMB(_bucket_lookup_)(const Self* self, const _m_keyraw* rkeyptr)
+    { return _c_MEMB(_bucket_lookup_hashed_)(self, rkeyptr, i_hash(rkeyptr)); }
+
+STC_INLINE _m_result _c_MEMB(_bucket_insert_)(const Self* self, const _m_keyraw* rkeyptr)
+    { return _c_MEMB(_bucket_insert_hashed_)(self, rkeyptr, i_hash(rkeyptr)); }
 
 STC_INLINE Self         _c_MEMB(_init)(void) { Self map = {0}; return map; }
 STC_INLINE void         _c_MEMB(_shrink_to_fit)(Self* self) { _c_MEMB(_reserve)(self, (isize)self->size); }
 STC_INLINE bool         _c_MEMB(_is_empty)(const Self* map) { return !map->size; }
 STC_INLINE isize        _c_MEMB(_size)(const Self* map) { return (isize)map->size; }
 STC_INLINE isize        _c_MEMB(_bucket_count)(Self* map) { return map->bucket_count; }
+
+STC_INLINE size_t _c_MEMB(_key_hash)(_m_keyraw rkey)
+    { return i_hash((&rkey)); }
+
+STC_INLINE _m_value* _c_MEMB(_lookup_hashed_)(const Self* self, const _m_keyraw* rkeyptr, size_t hash) {
+    _m_value* ref = self->size ? _c_MEMB(_bucket_lookup_hashed_)(self, rkeyptr, hash).ref : NULL;
+    #ifdef i_incremental_rehash
+    if (ref == NULL && self->_old.table != NULL) {
+        const Self _old = _c_MEMB(_old_)(self);
+        ref = _c_MEMB(_bucket_lookup_hashed_)(&_old, rkeyptr, hash).ref;
+    }
+    #endif
+    return ref;
+}
+
+STC_INLINE _m_value* _c_MEMB(_lookup_)(const Self* self, const _m_keyraw* rkeyptr)
+    { return self->size ? _c_MEMB(_lookup_hashed_)(self, rkeyptr, i_hash(rkeyptr)) : NULL; }
+
 STC_INLINE bool         _c_MEMB(_contains)(const Self* self, _m_keyraw rkey)
-                            { return self->size && _c_MEMB(_bucket_lookup_)(self, &rkey).ref; }
+                            { return _c_MEMB(_lookup_)(self, &rkey) != NULL; }
 
 #ifndef i_max_load_factor
   #define i_max_load_factor 0.80f
 #endif
+#if defined i_incremental_rehash && !defined i_rehash_steps
+  #define i_rehash_steps 8
+#endif
 
 STC_INLINE _m_result
-_c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey) {
+_c_MEMB(_insert_entry_hashed_)(Self* self, _m_keyraw rkey, size_t hash) {
     if (self->size >= (isize)((float)self->bucket_count * (i_max_load_factor)))
+      #ifdef i_incremental_rehash
+        if (!_c_MEMB(_grow_)(self, (isize)(self->size*3/2 + 2)))
+      #else
         if (!_c_MEMB(_reserve)(self, (isize)(self->size*3/2 + 2)))
+      #endif
             return c_literal(_m_result){0};
 
-    _m_result res = _c_MEMB(_bucket_insert_)(self, &rkey);
+    #ifdef i_incremental_rehash
+    if (self->_old.table != NULL) {
+        _m_result res = _c_MEMB(_rehash_step_)(self, &rkey, hash);
+        if (res.ref != NULL) // found in old table
+            return res;
+    }
+    #endif
+    _m_result res = _c_MEMB(_bucket_insert_hashed_)(self, &rkey, hash);
     self->size += res.inserted;
     return res;
 }
 
+STC_INLINE _m_result _c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_insert_entry_hashed_)(self, rkey, i_hash((&rkey))); }
+
 #ifdef _i_is_map
     STC_API _m_result _c_MEMB(_insert_or_assign)(Self* self, _m_key key, _m_mapped mapped);
     #if !defined i_no_emplace
@@ -131,13 +306,17 @@ _c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey) {
     #endif
 
     STC_INLINE const _m_mapped* _c_MEMB(_at)(const Self* self, _m_keyraw rkey) {
-        _m_result res = _c_MEMB(_bucket_lookup_)(self, &rkey);
-        c_assert(res.ref);
-        return &res.ref->second;
+        _m_value* ref = _c_MEMB(_lookup_)(self, &rkey);
+        c_assert(ref);
+        return &ref->second;
     }
 
-    STC_INLINE _m_mapped* _c_MEMB(_at_mut)(Self* self, _m_keyraw rkey)
-        { return (_m_mapped*)_c_MEMB(_at)(self, rkey); }
+    STC_INLINE _m_mapped* _c_MEMB(_at_mut)(Self* self, _m_keyraw rkey) {
+        #ifdef i_incremental_rehash
+        _c_MEMB(_migrate_)(self);
+        #endif
+        return (_m_mapped*)_c_MEMB(_at)(self, rkey);
+    }
 #endif // _i_is_map
 
 #if !defined i_no_clone
@@ -156,15 +335,20 @@ _c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey) {
 #endif // !i_no_clone
 
 #if !defined i_no_emplace
+    // hash must be _key_hash(rkey), e.g. computed earlier or by another map of the same key type.
     STC_INLINE _m_result
-    _c_MEMB(_emplace)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped)) {
-        _m_result _res = _c_MEMB(_insert_entry_)(self, rkey);
+    _c_MEMB(_emplace_hashed)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped), size_t hash) {
+        _m_result _res = _c_MEMB(_insert_entry_hashed_)(self, rkey, hash);
         if (_res.inserted) {
             *_i_keyref(_res.ref) = i_keyfrom(rkey);
             _i_MAP_ONLY( _res.ref->second = i_valfrom(rmapped); )
         }
         return _res;
     }
+
+    STC_INLINE _m_result
+    _c_MEMB(_emplace)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped))
+        { return _c_MEMB(_emplace_hashed)(self, rkey _i_MAP_ONLY(, rmapped), i_hash((&rkey))); }
 #endif // !i_no_emplace
 
 STC_INLINE _m_raw _c_MEMB(_value_toraw)(const _m_value* val) {
@@ -189,8 +373,8 @@ STC_INLINE void _c_MEMB(_take)(Self *self, Self unowned) {
 }
 
 STC_INLINE _m_result
-_c_MEMB(_insert)(Self* self, _m_key _key _i_MAP_ONLY(, _m_mapped _mapped)) {
-    _m_result _res = _c_MEMB(_insert_entry_)(self, i_keytoraw((&_key)));
+_c_MEMB(_insert_hashed)(Self* self, _m_key _key _i_MAP_ONLY(, _m_mapped _mapped), size_t hash) {
+    _m_result _res = _c_MEMB(_insert_entry_hashed_)(self, i_keytoraw((&_key)), hash);
     if (_res.inserted)
         { *_i_keyref(_res.ref) = _key; _i_MAP_ONLY( _res.ref->second = _mapped; )}
     else
@@ -198,6 +382,12 @@ _c_MEMB(_insert)(Self* self, _m_key _key _i_MAP_ONLY(, _m_mapped _mapped)) {
     return _res;
 }
 
+STC_INLINE _m_result
+_c_MEMB(_insert)(Self* self, _m_key _key _i_MAP_ONLY(, _m_mapped _mapped)) {
+    return _c_MEMB(_insert_hashed)(self, _key _i_MAP_ONLY(, _mapped),
+                                   _c_MEMB(_key_hash)(i_keytoraw((&_key))));
+}
+
 STC_INLINE _m_value* _c_MEMB(_push)(Self* self, _m_value _val) {
     _m_result _res = _c_MEMB(_insert_entry_)(self, i_keytoraw(_i_keyref(&_val)));
     if (_res.inserted)
@@ -236,8 +426,23 @@ STC_API _m_iter _c_MEMB(_begin)(const Self* self);
 STC_INLINE _m_iter _c_MEMB(_end)(const Self* self)
     { (void)self; return c_literal(_m_iter){0}; }
 
+#ifdef i_incremental_rehash
+// Past the end of the new table: continue with the entries not yet migrated.
+STC_INLINE void _c_MEMB(_iter_old_)(_m_iter* it) {
+    it->ref = it->_old.table, it->_mref = it->_old.meta;
+    it->_end = it->_old.table + it->_old.bucket_count;
+    it->_old.table = NULL;
+    while (it->_mref->dist == 0)
+        ++it->ref, ++it->_mref;
+}
+#endif
+
 STC_INLINE void _c_MEMB(_next)(_m_iter* it) {
     while ((++it->ref, (++it->_mref)->dist == 0)) ;
+    #ifdef i_incremental_rehash
+    if (it->ref == it->_end && it->_old.table != NULL)
+        _c_MEMB(_iter_old_)(it);
+    #endif
     if (it->ref == it->_end) it->ref = NULL;
 }
 
@@ -247,28 +452,56 @@ STC_INLINE _m_iter _c_MEMB(_advance)(_m_iter it, size_t n) {
 }
 
 STC_INLINE _m_iter
-_c_MEMB(_find)(const Self* self, _m_keyraw rkey) {
-    _m_value* ref;
-    if (self->size != 0 && (ref = _c_MEMB(_bucket_lookup_)(self, &rkey).ref) != NULL)
+_c_MEMB(_iter_)(const Self* self, _m_value* ref) {
+    if (ref == NULL)
+        return _c_MEMB(_end)(self);
+    #ifdef i_incremental_rehash
+    if (_c_MEMB(_in_old_)(self, ref))
         return c_literal(_m_iter){ref,
-                                  &self->table[self->bucket_count],
-                                  &self->meta[ref - self->table]};
-    return _c_MEMB(_end)(self);
+                                  &self->_old.table[self->_old.bucket_count],
+                                  &self->_old.meta[ref - self->_old.table]};
+    #endif
+    _m_iter it = {ref, &self->table[self->bucket_count], &self->meta[ref - self->table]};
+    #ifdef i_incremental_rehash
+    it._old.table = self->_old.table, it._old.meta = self->_old.meta;
+    it._old.bucket_count = self->_old.bucket_count;
+    #endif
+    return it;
 }
 
+STC_INLINE _m_iter
+_c_MEMB(_find)(const Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_iter_)(self, _c_MEMB(_lookup_)(self, &rkey)); }
+
+STC_INLINE _m_iter
+_c_MEMB(_find_hashed)(const Self* self, _m_keyraw rkey, size_t hash)
+    { return _c_MEMB(_iter_)(self, _c_MEMB(_lookup_hashed_)(self, &rkey, hash)); }
+
 STC_INLINE const _m_value*
 _c_MEMB(_get)(const Self* self, _m_keyraw rkey) {
-    return self->size ? _c_MEMB(_bucket_lookup_)(self, &rkey).ref : NULL;
+    return _c_MEMB(_lookup_)(self, &rkey);
+}
+
+STC_INLINE const _m_value*
+_c_MEMB(_get_hashed)(const Self* self, _m_keyraw rkey, size_t hash) {
+    return _c_MEMB(_lookup_hashed_)(self, &rkey, hash);
 }
 
 STC_INLINE _m_value*
-_c_MEMB(_get_mut)(Self* self, _m_keyraw rkey)
-    { return (_m_value*)_c_MEMB(_get)(self, rkey); }
+_c_MEMB(_get_mut)(Self* self, _m_keyraw rkey) {
+    #ifdef i_incremental_rehash
+    _c_MEMB(_migrate_)(self);
+    #endif
+    return (_m_value*)_c_MEMB(_get)(self, rkey);
+}
 
 STC_INLINE int
 _c_MEMB(_erase)(Self* self, _m_keyraw rkey) {
-    _m_value* ref;
-    if (self->size != 0 && (ref = _c_MEMB(_bucket_lookup_)(self, &rkey).ref) != NULL)
+    #ifdef i_incremental_rehash
+    _c_MEMB(_migrate_)(self);
+    #endif
+    _m_value* ref = _c_MEMB(_lookup_)(self, &rkey);
+    if (ref != NULL)
         { _c_MEMB(_erase_entry)(self, ref); return 1; }
     return 0;
 }
@@ -300,6 +533,12 @@ STC_DEF _m_iter _c_MEMB(_begin)(const Self* self) {
     it._end += self->bucket_count;
     while (it._mref->dist == 0)
         ++it.ref, ++it._mref;
+    #ifdef i_incremental_rehash // then the entries in the old table
+    it._old.table = self->_old.table, it._old.meta = self->_old.meta;
+    it._old.bucket_count = self->_old.bucket_count;
+    if (it.ref == it._end && it._old.table != NULL)
+        _c_MEMB(_iter_old_)(&it);
+    #endif
     if (it.ref == it._end) it.ref = NULL;
     return it;
 }
@@ -318,7 +557,22 @@ STC_DEF Self _c_MEMB(_with_capacity)(const isize cap) {
     return map;
 }
 
+#ifdef i_incremental_rehash
+static void _c_MEMB(_free_old_)(Self* self) {
+    i_free(self->_old.meta, (self->_old.bucket_count + 1)*c_sizeof *self->_old.meta);
+    i_free(self->_old.table, self->_old.bucket_count*c_sizeof *self->_old.table);
+    c_memset(&self->_old, 0, c_sizeof self->_old);
+}
+#endif
+
 static void _c_MEMB(_wipe_)(Self* self) {
+    #ifdef i_incremental_rehash
+    if (self->_old.table != NULL) { // drop the entries not yet migrated
+        Self _old = _c_MEMB(_old_)(self);
+        _c_MEMB(_wipe_)(&_old);
+        _c_MEMB(_free_old_)(self);
+    }
+    #endif
     if (self->size == 0)
         return;
     _m_value* d = self->table, *_end = &d[self->bucket_count];
@@ -334,6 +588,9 @@ STC_DEF void _c_MEMB(_drop)(const Self* cself) {
         _c_MEMB(_wipe_)(self);
         i_free(self->meta, (self->bucket_count + 1)*c_sizeof *self->meta);
         i_free(self->table, self->bucket_count*c_sizeof *self->table);
+        #ifdef i_store_hash
+        i_free(self->hashes, self->bucket_count*c_sizeof *self->hashes);
+        #endif
     }
 }
 
@@ -372,14 +629,48 @@ STC_DEF void _c_MEMB(_clear)(Self* self) {
     #endif // !i_no_emplace
 #endif // _i_is_map
 
+#if defined i_simd_probe && defined _hmap_GROUP
+// Probe whole groups while they don't wrap around the table end. Returns false
+// if the lookup is not yet concluded, and must be finished with scalar probing.
+static bool
+_c_MEMB(_group_lookup_)(const Self* self, const _m_keyraw* rkeyptr, const size_t _hash, _m_result* res) {
+    const size_t _idxmask = (size_t)self->bucket_count - 1;
+    while (res->idx + _hmap_GROUP <= (size_t)self->bucket_count && (unsigned)res->dist + _hmap_GROUP <= _distmask) {
+        uint32_t _stop, _match = _hmap_group_probe(&self->meta[res->idx], res->hashx, res->dist, &_stop);
+        if (_stop != 0)
+            _match &= (_stop & (~_stop + 1)) - 1; // only buckets before the first stop
+        for (; _match != 0; _match &= _match - 1) {
+            const int _k = c_trailing_zeros(_match);
+            if (!_i_hash_match(self, res->idx + (size_t)_k, _hash))
+                continue;
+            const _m_keyraw _raw = i_keytoraw(_i_keyref(&self->table[res->idx + (size_t)_k]));
+            if (i_eq((&_raw), rkeyptr)) {
+                res->idx += (size_t)_k;
+                res->dist = (uint16_t)(res->dist + _k);
+                res->ref = &self->table[res->idx];
+                return true;
+            }
+        }
+        if (_stop != 0) {
+            const int _k = c_trailing_zeros(_stop);
+            res->idx += (size_t)_k;
+            res->dist = (uint16_t)(res->dist + _k);
+            return true;
+        }
+        res->idx = (res->idx + _hmap_GROUP) & _idxmask;
+        res->dist += _hmap_GROUP;
+    }
+    return false;
+}
+#endif
+
 static _m_result
-_c_MEMB(_bucket_lookup_)(const Self* self, const _m_keyraw* rkeyptr) {
-    const size_t _hash = i_hash(rkeyptr);
+_c_MEMB(_bucket_lookup_hashed_)(const Self* self, const _m_keyraw* rkeyptr, const size_t _hash) {
     const size_t _idxmask = (size_t)self->bucket_count - 1;
     _m_result _res = {.idx=_hash & _idxmask, .hashx=(uint8_t)((_hash >> 24) & _hashmask), .dist=1};
 
     while (_res.dist <= self->meta[_res.idx].dist) {
-        if (self->meta[_res.idx].hashx == _res.hashx) {
+        if (self->meta[_res.idx].hashx == _res.hashx && _i_hash_match(self, _res.idx, _hash)) {
             const _m_keyraw _raw = i_keytoraw(_i_keyref(&self->table[_res.idx]));
             if (i_eq((&_raw), rkeyptr)) {
                 _res.ref = &self->table[_res.idx];
@@ -388,45 +679,126 @@ _c_MEMB(_bucket_lookup_)(const Self* self, const _m_keyraw* rkeyptr) {
         }
         _res.idx = (_res.idx + 1) & _idxmask;
         ++_res.dist;
+        #if defined i_simd_probe && defined _hmap_GROUP
+        // most lookups end within a few buckets; group probe the long sequences
+        if (_res.dist == 4 && _c_MEMB(_group_lookup_)(self, rkeyptr, _hash, &_res))
+            break;
+        #endif
     }
     return _res;
 }
 
+// Look up the keys in a pipeline: each key is hashed and its home bucket is
+// prefetched _hmap_BATCH keys ahead of its probe, so that the cache misses of
+// consecutive lookups overlap instead of stalling one at a time.
+// Writes the found entries to refs, or flags to found.
+static isize
+_c_MEMB(_lookup_n_)(const Self* self, const _m_keyraw* rkeys, const isize n,
+                    const _m_value** refs, bool* found) {
+    const size_t _idxmask = (size_t)self->bucket_count - 1;
+    size_t _hash[_hmap_BATCH];
+    isize count = 0;
+
+    for (isize i = 0; i < n + _hmap_BATCH; ++i) {
+        const int k = (int)(i % _hmap_BATCH);
+        if (i >= _hmap_BATCH) { // probe key i - _hmap_BATCH
+            const isize j = i - _hmap_BATCH;
+            const _m_value* ref = self->size ? _c_MEMB(_bucket_lookup_hashed_)(self, &rkeys[j], _hash[k]).ref : NULL;
+            #ifdef i_incremental_rehash
+            if (ref == NULL && self->_old.table != NULL) {
+                const Self _old = _c_MEMB(_old_)(self);
+                ref = _c_MEMB(_bucket_lookup_hashed_)(&_old, &rkeys[j], _hash[k]).ref;
+            }
+            #endif
+            count += ref != NULL;
+            if (refs) refs[j] = ref;
+            else found[j] = ref != NULL;
+        }
+        if (i < n && self->size) { // hash key i and prefetch its home bucket
+            _hash[k] = i_hash((&rkeys[i]));
+            c_prefetch(&self->meta[_hash[k] & _idxmask]);
+            c_prefetch(&self->table[_hash[k] & _idxmask]);
+        }
+    }
+    return count;
+}
+
+STC_DEF isize
+_c_MEMB(_get_n)(const Self* self, const _m_keyraw* rkeys, const isize n, const _m_value** out) {
+    return _c_MEMB(_lookup_n_)(self, rkeys, n, out, NULL);
+}
+
+STC_DEF isize
+_c_MEMB(_contains_n)(const Self* self, const _m_keyraw* rkeys, const isize n, bool* out) {
+    return _c_MEMB(_lookup_n_)(self, rkeys, n, NULL, out);
+}
+
 static _m_result
-_c_MEMB(_bucket_insert_)(const Self* self, const _m_keyraw* rkeyptr) {
-    _m_result res = _c_MEMB(_bucket_lookup_)(self, rkeyptr);
+_c_MEMB(_bucket_insert_hashed_)(const Self* self, const _m_keyraw* rkeyptr, const size_t _hash) {
+    _m_result res = _c_MEMB(_bucket_lookup_hashed_)(self, rkeyptr, _hash);
     if (res.ref) // bucket exists
         return res;
     res.ref = &self->table[res.idx];
+    #ifdef i_store_hash
+    const size_t _home = res.idx;
+    #endif
     res.inserted = true;
+    c_assert(res.dist <= _distmask); // PSL overflow: a (very) bad hash function
     struct hmap_meta mnew = {.hashx=(uint16_t)(res.hashx & _hashmask),
                              .dist=(uint16_t)(res.dist & _distmask)};
     struct hmap_meta mcur = self->meta[res.idx];
     self->meta[res.idx] = mnew;
+    #ifdef i_stats
+    uint16_t _top = mnew.dist;
+    #endif
 
     if (mcur.dist != 0) { // collision, reorder buckets
         size_t mask = (size_t)self->bucket_count - 1;
         _m_value dcur = *res.ref;
+        #ifdef i_store_hash
+        uint32_t hcur = self->hashes[res.idx];
+        #endif
         for (;;) {
             res.idx = (res.idx + 1) & mask;
+            c_assert(mcur.dist < _distmask);
             ++mcur.dist;
             if (self->meta[res.idx].dist == 0)
                 break;
             if (self->meta[res.idx].dist < mcur.dist) {
+                #ifdef i_stats
+                if (mcur.dist > _top) _top = mcur.dist;
+                #endif
                 c_swap(&mcur, &self->meta[res.idx]);
                 c_swap(&dcur, &self->table[res.idx]);
+                #ifdef i_store_hash
+                c_swap(&hcur, &self->hashes[res.idx]);
+                #endif
             }
         }
         self->meta[res.idx] = mcur;
         self->table[res.idx] = dcur;
+        #ifdef i_store_hash
+        self->hashes[res.idx] = hcur;
+        #endif
+        #ifdef i_stats
+        if (mcur.dist > _top) _top = mcur.dist;
+        #endif
     }
+    #ifdef i_stats
+    if (_top - 1 > self->_stats.peak_dist)
+        ((Self*)self)->_stats.peak_dist = _top - 1;
+    #endif
+    #ifdef i_store_hash
+    self->hashes[_home] = (uint32_t)_hash;
+    #endif
     return res;
 }
 
 
 #if !defined i_no_clone
-    STC_DEF Self
-    _c_MEMB(_clone)(Self map) {
+    static void
+    _c_MEMB(_clone_buckets_)(Self* self) {
+        Self map = *self;
         if (map.bucket_count != 0) {
             _m_value *d = _i_malloc(_m_value, map.bucket_count);
             const isize _mbytes = (map.bucket_count + 1)*c_sizeof *map.meta;
@@ -442,7 +814,57 @@ _c_MEMB(_bucket_insert_)(const Self* self, const _m_keyraw* rkeyptr) {
                 if (m != NULL) i_free(m, _mbytes);
                 d = 0, m = 0, map.bucket_count = 0;
             }
-            map.table = d, map.meta = m;
+            self->table = d, self->meta = m;
+            self->bucket_count = map.bucket_count;
+        }
+    }
+#endif
+
+#if !defined i_no_clone
+    #ifdef i_store_hash
+    // Clone a bucket array parallel to the entries.
+    static void*
+    _c_MEMB(_clone_array_)(Self* self, const void* arr, const isize bytes) {
+        (void)self; // used by i_malloc() with i_allocator_ctx
+        void* dst = i_malloc(bytes);
+        if (dst != NULL)
+            c_memcpy(dst, arr, bytes);
+        return dst;
+    }
+    #endif
+
+    STC_DEF Self
+    _c_MEMB(_clone)(Self map) {
+        const isize _buckets = map.bucket_count;
+        #ifdef i_store_hash
+        const uint32_t* hashes = map.hashes;
+        map.hashes = NULL;
+        #endif
+        _c_MEMB(_clone_buckets_)(&map);
+        bool ok = map.bucket_count == _buckets;
+        #ifdef i_store_hash
+        if (ok && _buckets != 0)
+            ok = (map.hashes = (uint32_t*)_c_MEMB(_clone_array_)(&map, hashes,
+                                              _buckets*c_sizeof *hashes)) != NULL;
+        #endif
+        #ifdef i_incremental_rehash
+        if (map._old.table != NULL) {
+            Self _old = _c_MEMB(_old_)(&map);
+            if (ok)
+                _c_MEMB(_clone_buckets_)(&_old);
+            else
+                _old.table = NULL, _old.meta = NULL, _old.bucket_count = 0;
+            ok = ok && _old.table != NULL;
+            map._old.table = _old.table, map._old.meta = _old.meta;
+            map._old.bucket_count = _old.bucket_count;
+        }
+        #endif
+        if (!ok) { // out of memory: the clone is empty, rather than missing entries
+            _c_MEMB(_drop)(&map);
+            map.table = NULL, map.meta = NULL, map.size = map.bucket_count = 0;
+            #ifdef i_store_hash
+            map.hashes = NULL;
+            #endif
         }
         return map;
     }
@@ -450,19 +872,24 @@ _c_MEMB(_bucket_insert_)(const Self* self, const _m_keyraw* rkeyptr) {
 
 STC_DEF bool
 _c_MEMB(_reserve)(Self* self, const isize _newcap) {
+    #ifdef i_incremental_rehash
+    _c_MEMB(_rehash_all_)(self);
+    #endif
     const isize _oldbucks = self->bucket_count;
     isize _newbucks = (isize)((float)_newcap / (i_max_load_factor)) + 4;
     _newbucks = c_next_pow2(_newbucks);
 
     if (_newcap < self->size || _newbucks == _oldbucks)
         return true;
-    Self map = {
-        _i_malloc(_m_value, _newbucks),
-        _i_calloc(struct hmap_meta, _newbucks + 1),
-        self->size, _newbucks
-    };
+    Self map = *self; // keeps aux and allocator context
+    map.table = _i_malloc(_m_value, _newbucks);
+    map.meta = _i_calloc(struct hmap_meta, _newbucks + 1);
+    map.bucket_count = _newbucks;
 
     bool ok = map.table && map.meta;
+    #ifdef i_store_hash
+    ok = (map.hashes = _i_malloc(uint32_t, _newbucks)) && ok;
+    #endif
     if (ok) {  // Rehash:
         map.meta[_newbucks].dist = _distmask; // end-mark for iter
         const _m_value* d = self->table;
@@ -470,44 +897,241 @@ _c_MEMB(_reserve)(Self* self, const isize _newcap) {
 
         for (isize i = 0; i < _oldbucks; ++i, ++d) if ((m++)->dist != 0) {
             _m_keyraw r = i_keytoraw(_i_keyref(d));
-            _m_result _res = _c_MEMB(_bucket_insert_)(&map, &r);
+            _m_result _res = _c_MEMB(_bucket_insert_hashed_)(&map, &r, _i_stored_hash(self, i, &r));
             *_res.ref = *d; // move
         }
         c_swap(self, &map);
+        #ifdef i_stats
+        self->_stats.rehashes += 1;
+        #endif
     }
     i_free(map.meta, (map.bucket_count + (int)(map.meta != NULL))*c_sizeof *map.meta);
     i_free(map.table, map.bucket_count*c_sizeof *map.table);
+    #ifdef i_store_hash
+    if (map.hashes != NULL) i_free(map.hashes, map.bucket_count*c_sizeof *map.hashes);
+    #endif
     return ok;
 }
 
-STC_DEF void
-_c_MEMB(_erase_entry)(Self* self, _m_value* _val) {
-    _m_value* d = self->table;
+// Remove bucket i by moving the following displaced buckets one step back.
+static void
+_c_MEMB(_unlink_)(Self* self, size_t i) {
     struct hmap_meta *m = self->meta;
-    size_t i = (size_t)(_val - d), j = i;
-    size_t mask = (size_t)self->bucket_count - 1;
+    size_t j = i, mask = (size_t)self->bucket_count - 1;
 
-    _c_MEMB(_value_drop)(_val);
     for (;;) {
         j = (j + 1) & mask;
         if (m[j].dist < 2) // 0 => empty, 1 => PSL 0
             break;
-        d[i] = d[j];
+        self->table[i] = self->table[j];
+        #ifdef i_store_hash
+        self->hashes[i] = self->hashes[j];
+        #endif
         m[i] = m[j];
         --m[i].dist;
         i = j;
     }
     m[i].dist = 0;
+}
+
+STC_DEF void
+_c_MEMB(_erase_entry)(Self* self, _m_value* _val) {
+    _c_MEMB(_value_drop)(_val);
+    #ifdef i_incremental_rehash
+    if (_c_MEMB(_in_old_)(self, _val)) {
+        Self _old = _c_MEMB(_old_)(self);
+        _c_MEMB(_unlink_)(&_old, (size_t)(_val - _old.table));
+    } else
+    #endif
+    _c_MEMB(_unlink_)(self, (size_t)(_val - self->table));
     --self->size;
 }
 
+#ifdef i_incremental_rehash
+// Start an incremental rehash: the current buckets become the old table, which
+// subsequent inserts and erases migrate to the new table, i_rehash_steps buckets at a time.
+static bool
+_c_MEMB(_grow_)(Self* self, const isize _newcap) {
+    _c_MEMB(_rehash_all_)(self);
+    if (self->size == 0)
+        return _c_MEMB(_reserve)(self, _newcap);
+
+    const isize _newbucks = c_next_pow2((isize)((float)_newcap / (i_max_load_factor)) + 4);
+    _m_value* d = _i_malloc(_m_value, _newbucks);
+    struct hmap_meta* m = _i_calloc(struct hmap_meta, _newbucks + 1);
+    if (d == NULL || m == NULL) {
+        i_free(m, (_newbucks + 1)*c_sizeof *m);
+        i_free(d, _newbucks*c_sizeof *d);
+        return false;
+    }
+    m[_newbucks].dist = _distmask; // end-mark for iter
+    self->_old.table = self->table, self->_old.meta = self->meta;
+    self->_old.bucket_count = self->bucket_count, self->_old.pos = 0;
+    self->table = d, self->meta = m, self->bucket_count = _newbucks;
+    #ifdef i_stats
+    self->_stats.rehashes += 1;
+    #endif
+    return true;
+}
+
+// Migrate up to i_rehash_steps buckets, then look up rkeyptr among the entries
+// still in the old table. Frees the old table when all buckets are migrated.
+static _m_result
+_c_MEMB(_rehash_step_)(Self* self, const _m_keyraw* rkeyptr, const size_t hash) {
+    Self _old = _c_MEMB(_old_)(self);
+    _m_result _res = {0};
+
+    for (int n = 0; n < (i_rehash_steps) && self->_old.pos < _old.bucket_count; ++n) {
+        const size_t i = (size_t)self->_old.pos;
+        if (_old.meta[i].dist == 0) {
+            ++self->_old.pos;
+            continue;
+        }
+        const _m_keyraw r = i_keytoraw(_i_keyref(&_old.table[i]));
+        *_c_MEMB(_bucket_insert_)(self, &r).ref = _old.table[i]; // move
+        _c_MEMB(_unlink_)(&_old, i);
+    }
+    if (self->_old.pos == _old.bucket_count)
+        _c_MEMB(_free_old_)(self);
+    else if (rkeyptr != NULL)
+        _res.ref = _c_MEMB(_bucket_lookup_hashed_)(&_old, rkeyptr, hash).ref;
+    return _res;
+}
+
+static void
+_c_MEMB(_rehash_all_)(Self* self) {
+    while (self->_old.table != NULL)
+        _c_MEMB(_rehash_step_)(self, NULL, 0);
+}
+#endif // i_incremental_rehash
+
+static isize // returns the sum of the probe sequence lengths
+_c_MEMB(_stats_add_)(hmap_stats* st, const struct hmap_meta* meta, const isize buckets) {
+    isize sum = 0;
+    for (isize i = 0; i < buckets; ++i) if (meta[i].dist != 0) {
+        const isize psl = meta[i].dist - 1;
+        st->dist_hist[psl < hmap_STATS_BINS ? psl : hmap_STATS_BINS - 1] += 1;
+        sum += psl;
+        if (psl > st->max_dist) st->max_dist = psl;
+    }
+    return sum;
+}
+
+STC_DEF hmap_stats
+_c_MEMB(_stats)(const Self* self) {
+    hmap_stats st = {.size=self->size, .bucket_count=self->bucket_count, .rehashes=-1, .peak_dist=-1};
+    if (self->bucket_count == 0)
+        return st;
+    isize dist_sum = _c_MEMB(_stats_add_)(&st, self->meta, self->bucket_count);
+    st.meta_bytes = (self->bucket_count + 1)*c_sizeof *self->meta;
+    st.table_bytes = self->bucket_count*c_sizeof *self->table;
+    #ifdef i_store_hash
+    st.extra_bytes += self->bucket_count*c_sizeof *self->hashes;
+    #endif
+    #ifdef i_incremental_rehash
+    if (self->_old.table != NULL) {
+        dist_sum += _c_MEMB(_stats_add_)(&st, self->_old.meta, self->_old.bucket_count);
+        st.extra_bytes += self->_old.bucket_count*c_sizeof *self->_old.table +
+                          (self->_old.bucket_count + 1)*c_sizeof *self->_old.meta;
+    }
+    #endif
+    #ifdef i_stats
+    st.rehashes = self->_stats.rehashes;
+    st.peak_dist = self->_stats.peak_dist;
+    #endif
+    if (st.size > 0) st.avg_dist = (float)((double)dist_sum / (double)st.size);
+    st.load_factor = (float)st.size / (float)st.bucket_count;
+    st.dist_warning = st.max_dist >= hmap_DIST_WARN || st.peak_dist >= hmap_DIST_WARN;
+    return st;
+}
+
+#ifdef i_snapshot
+static uint32_t _c_MEMB(_snapshot_flags_)(void) {
+    uint32_t flags = 0;
+    #ifdef i_store_hash
+    flags |= 2;
+    #endif
+    #ifdef _i_is_set
+    flags |= 4; // as in smap
+    #endif
+    return flags;
+}
+
+// Sections: entries, metadata, stored hashes. The hash of the first key is
+// stored, so that a view detects a hash function which differs, e.g. by a random seed.
+STC_DEF bool
+_c_MEMB(_write_snapshot)(const Self* self, const char* path) {
+    csnap_header hdr = {.kind=csnap_HMAP, .flags=_c_MEMB(_snapshot_flags_)(),
+                        .key_size=sizeof(_m_key), .value_size=sizeof(_m_value),
+                        .count=(uint64_t)self->size};
+    const void* section[csnap_SECTIONS] = {self->table, self->meta};
+    const uint64_t n = (uint64_t)self->bucket_count;
+    hdr.param[0] = n;
+    if (self->size > 0) {
+        const _m_keyraw r = i_keytoraw(_i_keyref(_c_MEMB(_begin)(self).ref));
+        hdr.param[1] = (uint64_t)i_hash((&r));
+    }
+    if (n > 0) {
+        hdr.bytes[0] = n*sizeof *self->table;
+        hdr.bytes[1] = (n + 1)*sizeof *self->meta;
+        #ifdef i_store_hash
+        section[2] = self->hashes, hdr.bytes[2] = n*sizeof *self->hashes;
+        #endif
+    }
+    return csnap_write(path, hdr, section);
+}
+
+STC_DEF bool
+_c_MEMB(_view_snapshot)(Self* view, const csnap* snap) {
+    const csnap_header* h = csnap_check(snap, csnap_HMAP, _c_MEMB(_snapshot_flags_)(),
+                                        c_sizeof(_m_key), c_sizeof(_m_value));
+    if (h == NULL)
+        return false;
+    const uint64_t n = h->param[0];
+    Self map;
+    c_memset(&map, 0, c_sizeof map);
+    map.size = (isize)h->count, map.bucket_count = (isize)n;
+    bool ok = h->bytes[0] == n*sizeof *map.table;
+    #ifdef i_store_hash
+    ok = ok && h->bytes[2] == n*sizeof *map.hashes;
+    map.hashes = (uint32_t*)csnap_section(snap, 2);
+    #endif
+    ok = ok && (n & (n - 1)) == 0 && h->count <= n && h->bytes[1] == (n ? n + 1 : 0)*sizeof *map.meta;
+    if (!ok)
+        return false;
+    map.table = (_m_value*)csnap_section(snap, 0);
+    map.meta = (struct hmap_meta*)csnap_section(snap, 1);
+    if (map.size > 0) {
+        const _m_keyraw r = i_keytoraw(_i_keyref(_c_MEMB(_begin)(&map).ref));
+        if ((uint64_t)i_hash((&r)) != h->param[1])
+            return false;
+    }
+    *view = map;
+    return true;
+}
+#endif // i_snapshot
+
 #endif // i_implement
 #undef i_max_load_factor
+#undef i_simd_probe
+#undef i_incremental_rehash
+#undef i_rehash_steps
+#undef i_store_hash
+#undef i_stats
+#undef i_snapshot
+#undef _i_hash_match
+#undef _i_stored_hash
+#undef _i_rehash_struct
+#undef _i_rehash_iter_struct
+#undef _i_bucket_struct
+#undef _i_stats_struct
 #undef _i_is_set
 #undef _i_is_map
 #undef _i_is_hash
 #undef _i_keyref
 #undef _i_MAP_ONLY
 #undef _i_SET_ONLY
+#ifndef _i_is_shard // sync_map.h keeps the template parameters for its wrapper type
 #include "priv/linkage2.h"
 #include "priv/template2.h"
+#endif
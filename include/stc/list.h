@@ -227,7 +227,8 @@ STC_INLINE bool _c_MEMB(_eq)(const Self* self, const Self* other) {
 #if !defined i_no_clone
 STC_DEF Self
 _c_MEMB(_clone)(Self lst) {
-    Self tmp = {0};
+    Self tmp = lst; // keeps aux and allocator context
+    tmp.last = NULL;
     for (c_each(it, Self, lst))
         _c_MEMB(_push_back)(&tmp, i_keyclone((*it.ref)));
     lst.last = tmp.last;
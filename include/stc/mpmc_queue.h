@@ -0,0 +1,166 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Bounded lock-free multi-producer/multi-consumer queue. Implemented as a ring
+// buffer where every slot carries a sequence number (D. Vyukov's algorithm).
+// Producers and consumers claim slots with a CAS on tail/head only.
+#include "priv/linkage.h"
+#include "types.h"
+
+#ifndef STC_MPMC_QUEUE_H_INCLUDED
+#define STC_MPMC_QUEUE_H_INCLUDED
+#include "common.h"
+#include <stdlib.h>
+#include "priv/atomic_prv.h"
+#endif // STC_MPMC_QUEUE_H_INCLUDED
+
+#ifndef _i_prefix
+  #define _i_prefix mpmc_queue_
+#endif
+#define i_no_clone
+#include "priv/template.h"
+
+#ifndef i_declared
+_c_DEFTYPES(_c_mpmc_queue_types, Self, i_key);
+#endif
+typedef i_keyraw _m_raw;
+
+// Capacity is rounded up to a power of two. Returns a queue with zero capacity
+// if allocation fails. Not thread-safe: construct before sharing the queue.
+STC_INLINE Self _c_MEMB(_with_capacity)(isize cap) {
+    Self q; memset(&q, 0, sizeof q);
+    cap = c_next_pow2(cap < 2 ? 2 : cap);
+    q.slots = _i_malloc(_c_MEMB(_slot), cap);
+    if (q.slots == NULL) return q;
+    q.capmask = cap - 1;
+    for (c_range(i, cap))
+        c_atomic_store_relaxed(&q.slots[i].seq, i);
+    c_atomic_store_relaxed(&q.head, 0);
+    c_atomic_store_relaxed(&q.tail, 0);
+    return q;
+}
+
+STC_INLINE isize _c_MEMB(_capacity)(const Self* self)
+    { return self->slots ? self->capmask + 1 : 0; }
+
+// A snapshot only, when other threads are pushing or popping.
+STC_INLINE isize _c_MEMB(_size)(const Self* self) {
+    isize n = c_atomic_load_relaxed(&((Self*)self)->tail) -
+              c_atomic_load_relaxed(&((Self*)self)->head);
+    return n < 0 ? 0 : n > _c_MEMB(_capacity)(self) ? _c_MEMB(_capacity)(self) : n;
+}
+
+STC_INLINE bool _c_MEMB(_is_empty)(const Self* self)
+    { return _c_MEMB(_size)(self) == 0; }
+
+STC_INLINE void _c_MEMB(_value_drop)(_m_value* val)
+    { i_keydrop(val); }
+
+// Claim up to n consecutive slots ready for pushing (or popping when pop=1).
+// Returns the number of slots claimed, starting at position *pos.
+STC_INLINE isize _c_MEMB(_claim_)(Self* self, isize n, isize* pos, const int pop) {
+    catomic_isize* end = pop ? &self->head : &self->tail;
+    isize p = c_atomic_load_relaxed(end);
+    if (self->slots == NULL) return 0;
+    for (;;) {
+        isize m = 0, dif = 0;
+        while (m < n) {
+            _c_MEMB(_slot)* s = &self->slots[(p + m) & self->capmask];
+            dif = c_atomic_load_acquire(&s->seq) - (p + m + pop);
+            if (dif != 0) break;
+            ++m;
+        }
+        if (m > 0) {
+            if (c_atomic_cas_weak(end, &p, p + m)) { // on failure, p is reloaded
+                *pos = p;
+                return m;
+            }
+        } else if (dif < 0) {
+            return 0; // full when pushing, empty when popping
+        } else {
+            p = c_atomic_load_relaxed(end); // another thread got ahead
+        }
+    }
+}
+
+// Moves n values into the queue. Returns number of values pushed, which is less
+// than n when the queue became full. The remaining values are still owned by the caller.
+STC_INLINE isize _c_MEMB(_try_push_n)(Self* self, _m_value* values, isize n) {
+    isize pos, m = _c_MEMB(_claim_)(self, n, &pos, 0);
+    for (c_range(i, m)) {
+        _c_MEMB(_slot)* s = &self->slots[(pos + i) & self->capmask];
+        s->value = values[i];
+        c_atomic_store_release(&s->seq, pos + i + 1);
+    }
+    return m;
+}
+
+// Returns false if the queue is full. Then value is still owned by the caller.
+STC_INLINE bool _c_MEMB(_try_push)(Self* self, _m_value value)
+    { return _c_MEMB(_try_push_n)(self, &value, 1) == 1; }
+
+#if !defined i_no_emplace
+// Constructs the value from raw only when there is room for it.
+STC_INLINE bool _c_MEMB(_try_emplace)(Self* self, _m_raw raw) {
+    isize pos;
+    if (_c_MEMB(_claim_)(self, 1, &pos, 0) == 0) return false;
+    _c_MEMB(_slot)* s = &self->slots[pos & self->capmask];
+    s->value = i_keyfrom(raw);
+    c_atomic_store_release(&s->seq, pos + 1);
+    return true;
+}
+#endif
+
+// Moves up to n values from the front of the queue into out[].
+// Returns number of values popped, which is less than n when the queue became empty.
+STC_INLINE isize _c_MEMB(_try_pop_n)(Self* self, _m_value* out, isize n) {
+    isize pos, m = _c_MEMB(_claim_)(self, n, &pos, 1);
+    for (c_range(i, m)) {
+        _c_MEMB(_slot)* s = &self->slots[(pos + i) & self->capmask];
+        out[i] = s->value;
+        c_atomic_store_release(&s->seq, pos + i + self->capmask + 1);
+    }
+    return m;
+}
+
+// Returns false if the queue is empty. Drops the popped value if out is NULL.
+STC_INLINE bool _c_MEMB(_try_pop)(Self* self, _m_value* out) {
+    _m_value val;
+    if (_c_MEMB(_try_pop_n)(self, &val, 1) == 0) return false;
+    if (out) *out = val;
+    else { i_keydrop((&val)); }
+    return true;
+}
+
+// Not thread-safe: all producers and consumers must be done.
+STC_INLINE void _c_MEMB(_clear)(Self* self)
+    { while (_c_MEMB(_try_pop)(self, NULL)) ; }
+
+STC_INLINE void _c_MEMB(_drop)(const Self* cself) {
+    Self* self = (Self*)cself;
+    _c_MEMB(_clear)(self);
+    i_free(self->slots, _c_MEMB(_capacity)(self)*c_sizeof(*self->slots));
+}
+
+#include "priv/linkage2.h"
+#include "priv/template2.h"
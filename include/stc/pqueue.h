@@ -151,12 +151,12 @@ _c_MEMB(_make_heap)(Self* self) {
 
 #if !defined i_no_clone
 STC_DEF Self _c_MEMB(_clone)(Self q) {
-    Self tmp = _c_MEMB(_with_capacity)(q.size);
-    for (; tmp.size < q.size; ++q.data)
-        tmp.data[tmp.size++] = i_keyclone((*q.data));
-    q.data = tmp.data;
-    q.capacity = tmp.capacity;
-    return q;
+    Self tmp = q; // keeps aux and allocator context
+    tmp.data = NULL, tmp.size = tmp.capacity = 0;
+    if (_c_MEMB(_reserve)(&tmp, q.size))
+        for (; tmp.size < q.size; ++q.data)
+            tmp.data[tmp.size++] = i_keyclone((*q.data));
+    return tmp;
 }
 #endif
 
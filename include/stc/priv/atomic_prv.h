@@ -0,0 +1,52 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+// IWYU pragma: private
+#ifndef STC_ATOMIC_PRV_H_INCLUDED
+#define STC_ATOMIC_PRV_H_INCLUDED
+
+// Minimal atomics shared by the concurrent containers and the coroutine executor.
+// Read-modify-write operations are acquire-release; CAS is relaxed.
+#if defined __GNUC__ || defined __clang__
+    typedef ptrdiff_t catomic_isize;
+    #define c_atomic_load_relaxed(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+    #define c_atomic_load_acquire(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+    #define c_atomic_store_relaxed(p, v) __atomic_store_n(p, v, __ATOMIC_RELAXED)
+    #define c_atomic_store_release(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+    #define c_atomic_fetch_add(p, v) __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL)
+    #define c_atomic_fetch_sub(p, v) __atomic_fetch_sub(p, v, __ATOMIC_ACQ_REL)
+    #define c_atomic_cas_weak(p, expected, v) \
+        __atomic_compare_exchange_n(p, expected, v, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#else // try with C11
+    #include <stdatomic.h>
+    typedef _Atomic(ptrdiff_t) catomic_isize;
+    #define c_atomic_load_relaxed(p) atomic_load_explicit(p, memory_order_relaxed)
+    #define c_atomic_load_acquire(p) atomic_load_explicit(p, memory_order_acquire)
+    #define c_atomic_store_relaxed(p, v) atomic_store_explicit(p, v, memory_order_relaxed)
+    #define c_atomic_store_release(p, v) atomic_store_explicit(p, v, memory_order_release)
+    #define c_atomic_fetch_add(p, v) atomic_fetch_add_explicit(p, v, memory_order_acq_rel)
+    #define c_atomic_fetch_sub(p, v) atomic_fetch_sub_explicit(p, v, memory_order_acq_rel)
+    #define c_atomic_cas_weak(p, expected, v) \
+        atomic_compare_exchange_weak_explicit(p, expected, v, memory_order_relaxed, memory_order_relaxed)
+#endif
+
+#endif // STC_ATOMIC_PRV_H_INCLUDED
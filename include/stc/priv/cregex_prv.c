@@ -27,6 +27,8 @@ THE SOFTWARE.
 #define STC_CREGEX_PRV_C_INCLUDED
 
 #include <setjmp.h>
+#include <stdlib.h>
+#include "atomic_prv.h"
 #include "utf8_prv.h"
 #include "cstr_prv.h"
 #include "ucd_prv.c"
@@ -78,8 +80,13 @@ typedef struct {
 typedef struct _Reprog
 {
     _Reinst  *startinst;     /* start pc */
+    struct _Redfa *dfa;      /* lazy DFA, or NULL if not supported by the program */
     _Reflags flags;
     int nsubids;
+    int ninst;               /* number of instructions */
+    uint8_t nprefix, nliteral;
+    char prefix[16];         /* literal that every match starts with */
+    char literal[32];        /* longest literal that every match contains */
     isize allocsize;
     _Reclass cclass[_NCLASS]; /* .data */
     _Reinst  firstinst[];    /* .text : originally 5 elements? */
@@ -199,17 +206,21 @@ typedef struct _Reljunk
     _Rune       startchar;
     const char* starts;
     const char* eol;
+    int         flag;       /* index of the current list */
+    int         match;
+    bool        icase;
 } _Reljunk;
 
 /*
  * utf8 and _Rune code
  */
 
+/* decode the rune at s, reading no further than end unless it is NULL */
 static inline int
-chartorune(_Rune *rune, const char *s)
+chartorune(_Rune *rune, const char *s, const char *end)
 {
     utf8_decode_t d = {.state=0};
-    int n = utf8_decode_codepoint(&d, s, NULL);
+    int n = utf8_decode_codepoint(&d, s, end);
     *rune = d.codep;
     return n;
 }
@@ -248,6 +259,23 @@ utfruneicase(const char *s, _Rune c) {
     return NULL;
 }
 
+/* search literal lit of length n in s, up to eol if not NULL */
+static inline const char*
+_find_literal(const char *s, const char *eol, const char *lit, int n)
+{
+    if (eol == NULL)
+        return strstr(s, lit);
+    return c_strnstrn(s, eol - s, lit, n);
+}
+
+/* rune before s, which must be after start of input */
+static inline _Rune
+_prevrune(const char *s)
+{
+    do --s; while ((*s & 0xC0) == 0x80);
+    return utf8_peek(s);
+}
+
 /************
  * regaux.c *
  ************/
@@ -610,7 +638,7 @@ _nextc(_Parser *par, _Rune *rp)
     int ret;
     for (;;) {
         ret = par->litmode;
-        par->exprp += chartorune(rp, par->exprp);
+        par->exprp += chartorune(rp, par->exprp, NULL);
 
         if (*rp == '\\') {
             if (par->litmode) {
@@ -620,7 +648,7 @@ _nextc(_Parser *par, _Rune *rp)
                 par->litmode = false;
                 continue;
             }
-            par->exprp += chartorune(rp, par->exprp);
+            par->exprp += chartorune(rp, par->exprp, NULL);
             if (*rp == 'Q') {
                 par->litmode = true;
                 continue;
@@ -860,6 +888,86 @@ _bldcclass(_Parser *par)
 }
 
 
+/*
+ *  Literals used to skip ahead in the input: the prefix that every match starts
+ *  with, and the longest run of literal runes that every match must contain.
+ */
+static const _Reinst*
+_lit_skip(const _Reinst *inst)
+{
+    while (inst->type == TOK_NOP || inst->type == TOK_LBRA || inst->type == TOK_RBRA ||
+           inst->type == TOK_CASED || inst->type == TOK_ICASE)
+        inst = inst->l.next;
+    return inst;
+}
+
+/* a rune that matches only its own utf8 encoding. U+FFFD also matches invalid utf8 */
+static inline bool
+_lit_rune(const _Reinst *inst)
+{
+    return inst->type == TOK_RUNE && inst->r.rune > 0 && inst->r.rune < 0x110000 &&
+           inst->r.rune != 0xFFFD;
+}
+
+/* copy the utf8 run of literal runes starting at inst into buf. return its length */
+static int
+_lit_run(const _Reinst *inst, char *buf, int cap)
+{
+    int n = 0;
+    for (inst = _lit_skip(inst); _lit_rune(inst) && n + 4 < cap; inst = _lit_skip(inst->l.next))
+        n += utf8_encode(buf + n, inst->r.rune);
+    buf[n] = '\0';
+    return n;
+}
+
+/* can the program reach TOK_END without passing through inst avoid? */
+static bool
+_lit_bypass(const _Reprog *pp, const _Reinst *avoid, uint8_t *seen, const _Reinst **stack, isize ninst)
+{
+    isize sp = 0;
+    memset(seen, 0, (size_t)ninst);
+    stack[sp++] = pp->startinst;
+    while (sp) {
+        const _Reinst *inst = stack[--sp];
+        if (inst == avoid || seen[inst - pp->firstinst])
+            continue;
+        seen[inst - pp->firstinst] = 1;
+        if (inst->type == TOK_END)
+            return true;
+        stack[sp++] = inst->l.next;
+        if (inst->type == TOK_OR)
+            stack[sp++] = inst->r.right;
+    }
+    return false;
+}
+
+static void
+_compile_literals(_Reprog *pp, isize ninst)
+{
+    char buf[sizeof pp->literal];
+    pp->nprefix = (uint8_t)_lit_run(pp->startinst, pp->prefix, sizeof pp->prefix);
+    pp->nliteral = pp->nprefix;
+    memcpy(pp->literal, pp->prefix, sizeof pp->prefix);
+    if (ninst > 4096) /* the search below is quadratic */
+        return;
+
+    uint8_t *seen = (uint8_t *)i_malloc(ninst);
+    const _Reinst **stack = (const _Reinst **)i_malloc((2*ninst + 1)*c_sizeof *stack);
+    if (seen && stack) {
+        for (const _Reinst *inst = pp->firstinst; inst < pp->firstinst + ninst; ++inst) {
+            if (!_lit_rune(inst))
+                continue;
+            int n = _lit_run(inst, buf, sizeof buf);
+            if (n > pp->nliteral && !_lit_bypass(pp, inst, seen, stack, ninst)) {
+                memcpy(pp->literal, buf, (size_t)n + 1);
+                pp->nliteral = (uint8_t)n;
+            }
+        }
+    }
+    i_free(stack, (2*ninst + 1)*c_sizeof *stack);
+    i_free(seen, ninst);
+}
+
 static _Reprog*
 _regcomp1(_Reprog *pp, _Parser *par, const char *s, int cflags)
 {
@@ -919,6 +1027,8 @@ _regcomp1(_Reprog *pp, _Parser *par, const char *s, int cflags)
     --par->andp;    /* points to first and only _operand */
     pp->startinst = par->andp->first;
 
+    pp->ninst = (int)(par->freep - pp->firstinst);
+    _compile_literals(pp, pp->ninst);
     pp = _optimize(par, pp);
     pp->nsubids = par->cursubid;
 out:
@@ -992,6 +1102,123 @@ _runematch(_Rune s, _Rune r)
     return s == r;
 }
 
+/*
+ *  run the machine one step at s, where r is the rune at s: the threads of the
+ *  current list add their successors to the next list, which becomes current.
+ *  return <0 if we ran out of _relist space
+ */
+static int
+_regstep(const _Reprog *progp,  /* program to run */
+    const char *bol,    /* start of string, or NULL if before input */
+    _Resub *mp,         /* subexpression elements */
+    int ms,             /* number of elements at mp */
+    _Reljunk *j,
+    int mflags,
+    const char *s,
+    _Rune r
+)
+{
+    _Reinst *inst;
+    _Relist *tlp;
+    _Relist *tl, *nl;    /* This list, next list */
+    _Relist *tle, *nle;  /* Ends of this and next list */
+    _Rune *rp, *ep;
+    int ok;
+
+    /* switch run lists */
+    tl = j->relist[j->flag];
+    tle = j->reliste[j->flag];
+    nl = j->relist[j->flag ^= 1];
+    nle = j->reliste[j->flag];
+    nl->inst = NULL;
+
+    /* Add first instruction to current list */
+    if (j->match == 0)
+        _renewemptythread(tl, progp->startinst, ms, s);
+
+    /* Execute machine until current list is empty */
+    for (tlp=tl; tlp->inst; tlp++) {    /* assignment = */
+        for (inst = tlp->inst; ; inst = inst->l.next) {
+            ok = false;
+
+            switch (inst->type) {
+            case TOK_IRUNE:
+                r = utf8_casefold(r); /* FALLTHRU */
+            case TOK_RUNE:
+                ok = _runematch(inst->r.rune, r);
+                break;
+            case TOK_CASED: case TOK_ICASE:
+                j->icase = inst->type == TOK_ICASE;
+                continue;
+            case TOK_LBRA:
+                tlp->se.m[inst->r.subid].buf = s;
+                continue;
+            case TOK_RBRA:
+                tlp->se.m[inst->r.subid].size = (s - tlp->se.m[inst->r.subid].buf);
+                continue;
+            case TOK_ANY:
+                ok = (r != '\n');
+                break;
+            case TOK_ANYNL:
+                ok = true;
+                break;
+            case TOK_BOL:
+                if (s == bol || s[-1] == '\n') continue;
+                break;
+            case TOK_BOS:
+                if (s == bol) continue;
+                break;
+            case TOK_EOL:
+                if (r == '\n') continue; /* FALLTHRU */
+            case TOK_EOS:
+                if (s == j->eol || r == 0) continue;
+                break;
+            case TOK_EOZ:
+                if (s == j->eol || r == 0 || (r == '\n' && s[1] == 0)) continue;
+                break;
+            case TOK_NWBOUND:
+                ok = true; /* FALLTHRU */
+            case TOK_WBOUND:
+                if (ok ^ (s == bol || s == j->eol || (utf8_isword(_prevrune(s))
+                                                    ^ utf8_isword(utf8_peek(s)))))
+                    continue;
+                ok = false;
+                break;
+            case TOK_NCCLASS:
+                ok = true; /* FALLTHRU */
+            case TOK_CCLASS:
+                ep = inst->r.classp->end;
+                if (j->icase) r = utf8_casefold(r);
+                for (rp = inst->r.classp->spans; rp < ep; rp += 2) {
+                    if ((r >= rp[0] && r <= rp[1]) || (rp[0] == rp[1] && _runematch(rp[0], r)))
+                        break;
+                }
+                ok ^= (rp < ep);
+                break;
+            case TOK_OR:
+                /* evaluate right choice later */
+                if (_renewthread(tlp, inst->r.right, ms, &tlp->se) == tle)
+                    return -1;
+                /* efficiency: advance and re-evaluate */
+                continue;
+            case TOK_END:    /* Match! */
+                j->match = !(mflags & CREG_FULLMATCH) ||
+                           ((s == j->eol || r == 0 || r == '\n') &&
+                           (tlp->se.m[0].buf == bol || tlp->se.m[0].buf[-1] == '\n'));
+                tlp->se.m[0].size = (s - tlp->se.m[0].buf);
+                if (mp != NULL)
+                    _renewmatch(mp, ms, &tlp->se, progp->nsubids);
+                break;
+            }
+
+            if (ok && _renewthread(nl, inst->l.next, ms, &tlp->se) == nle)
+                return -1;
+            break;
+        }
+    }
+    return 0;
+}
+
 /*
  *  return 0 if no match
  *        >0 if a match
@@ -1006,17 +1233,14 @@ _regexec1(const _Reprog *progp,  /* program to run */
     int mflags
 )
 {
-    int flag=0;
-    _Reinst *inst;
-    _Relist *tlp;
-    _Relist *tl, *nl;    /* This list, next list */
-    _Relist *tle, *nle;  /* Ends of this and next list */
     const char *s, *p;
-    _Rune r, *rp, *ep;
-    int n, checkstart, match = 0;
+    _Rune r;
+    int n, checkstart;
     int i;
 
-    bool icase = progp->flags.icase;
+    j->icase = progp->flags.icase;
+    j->flag = 0;
+    j->match = 0;
     checkstart = j->starttype;
     if (mp)
         for (i=0; i<ms; i++) {
@@ -1036,121 +1260,37 @@ _regexec1(const _Reprog *progp,  /* program to run */
                 p = utfruneicase(s, j->startchar);
                 goto next1;
             case TOK_RUNE:
-                p = utfrune(s, j->startchar);
+                p = _find_literal(s, j->eol, progp->prefix, progp->nprefix);
                 next1:
-                if (p == NULL || s == j->eol)
-                    return match;
+                if (p == NULL || (j->eol && p >= j->eol))
+                    return j->match;
                 s = p;
                 break;
             case TOK_BOL:
-                if (s == bol)
+                if (s == bol || s[-1] == '\n')
                     break;
                 p = utfrune(s, '\n');
-                if (p == NULL || s == j->eol)
-                    return match;
+                if (p == NULL || (j->eol && p >= j->eol))
+                    return j->match;
                 s = p+1;
                 break;
             }
         }
-        r = *(uint8_t*)s;
-        n = r < 0x80 ? 1 : chartorune(&r, s);
-
-        /* switch run lists */
-        tl = j->relist[flag];
-        tle = j->reliste[flag];
-        nl = j->relist[flag^=1];
-        nle = j->reliste[flag];
-        nl->inst = NULL;
-
-        /* Add first instruction to current list */
-        if (match == 0)
-            _renewemptythread(tl, progp->startinst, ms, s);
-
-        /* Execute machine until current list is empty */
-        for (tlp=tl; tlp->inst; tlp++) {    /* assignment = */
-            for (inst = tlp->inst; ; inst = inst->l.next) {
-                int ok = false;
-
-                switch (inst->type) {
-                case TOK_IRUNE:
-                    r = utf8_casefold(r); /* FALLTHRU */
-                case TOK_RUNE:
-                    ok = _runematch(inst->r.rune, r);
-                    break;
-                case TOK_CASED: case TOK_ICASE:
-                    icase = inst->type == TOK_ICASE;
-                    continue;
-                case TOK_LBRA:
-                    tlp->se.m[inst->r.subid].buf = s;
-                    continue;
-                case TOK_RBRA:
-                    tlp->se.m[inst->r.subid].size = (s - tlp->se.m[inst->r.subid].buf);
-                    continue;
-                case TOK_ANY:
-                    ok = (r != '\n');
-                    break;
-                case TOK_ANYNL:
-                    ok = true;
-                    break;
-                case TOK_BOL:
-                    if (s == bol || s[-1] == '\n') continue;
-                    break;
-                case TOK_BOS:
-                    if (s == bol) continue;
-                    break;
-                case TOK_EOL:
-                    if (r == '\n') continue; /* FALLTHRU */
-                case TOK_EOS:
-                    if (s == j->eol || r == 0) continue;
-                    break;
-                case TOK_EOZ:
-                    if (s == j->eol || r == 0 || (r == '\n' && s[1] == 0)) continue;
-                    break;
-                case TOK_NWBOUND:
-                    ok = true; /* FALLTHRU */
-                case TOK_WBOUND:
-                    if (ok ^ (s == bol || s == j->eol || (utf8_isword(utf8_peek_at(s, -1))
-                                                        ^ utf8_isword(utf8_peek(s)))))
-                        continue;
-                    break;
-                case TOK_NCCLASS:
-                    ok = true; /* FALLTHRU */
-                case TOK_CCLASS:
-                    ep = inst->r.classp->end;
-                    if (icase) r = utf8_casefold(r);
-                    for (rp = inst->r.classp->spans; rp < ep; rp += 2) {
-                        if ((r >= rp[0] && r <= rp[1]) || (rp[0] == rp[1] && _runematch(rp[0], r)))
-                            break;
-                    }
-                    ok ^= (rp < ep);
-                    break;
-                case TOK_OR:
-                    /* evaluate right choice later */
-                    if (_renewthread(tlp, inst->r.right, ms, &tlp->se) == tle)
-                        return -1;
-                    /* efficiency: advance and re-evaluate */
-                    continue;
-                case TOK_END:    /* Match! */
-                    match = !(mflags & CREG_FULLMATCH) ||
-                            ((s == j->eol || r == 0 || r == '\n') &&
-                            (tlp->se.m[0].buf == bol || tlp->se.m[0].buf[-1] == '\n'));
-                    tlp->se.m[0].size = (s - tlp->se.m[0].buf);
-                    if (mp != NULL)
-                        _renewmatch(mp, ms, &tlp->se, progp->nsubids);
-                    break;
-                }
+        if (s == j->eol) /* do not read past a CREG_STARTEND view */
+            r = 0, n = 0;
+        else if ((r = *(uint8_t*)s) < 0x80)
+            n = 1;
+        else
+            n = chartorune(&r, s, j->eol);
 
-                if (ok && _renewthread(nl, inst->l.next, ms, &tlp->se) == nle)
-                    return -1;
-                break;
-            }
-        }
-        if (s == j->eol)
-            break;
-        checkstart = j->starttype && nl->inst==NULL;
+        if (_regstep(progp, bol, mp, ms, j, mflags, s, r) < 0)
+            return -1;
+        if (s == j->eol || (j->match && j->relist[j->flag]->inst == NULL))
+            break; /* no thread left that could change the match */
+        checkstart = j->starttype && j->relist[j->flag]->inst == NULL;
         s += n;
     } while (r);
-    return match;
+    return j->match;
 }
 
 
@@ -1182,6 +1322,548 @@ _regexec2(const _Reprog *progp,    /* program to run */
     return rv;
 }
 
+/*
+ *  Lazy DFA: a DFA state is a set of NFA instructions, built on demand from the
+ *  program and cached in _Reprog. Used to decide whether there is a match at all,
+ *  so the NFA only runs to extract match positions and captures.
+ *  Transitions on ascii bytes are cached in a table, with one column per class of
+ *  bytes that the program can not tell apart; other runes are computed.
+ *  Context for ^ and \b is kept in state flags, while $ and \b look at the
+ *  transition symbol. Symbol 0 is end of string (only NUL is in class 0), and
+ *  symbol eov is end of input view.
+ */
+enum {
+    _DFA_MAXSTATES = 1024,
+    _DFA_MAXSTATES_SET = 8192,
+    _DFA_ATSTART = 1, _DFA_PREVNL = 2, _DFA_PREVWORD = 4,
+    _DFA_ENDSET = 8, /* not a state: TOK_END's reached at end of input in report mode */
+};
+
+typedef struct _Redfa
+{
+    int32_t*    trans;      /* [state][sym]: -1 = not built, else next*nsym<<2 | idle<<1 | matched */
+    int32_t*    setpos;     /* [state+1] offsets into pcs */
+    uint8_t*    flags;      /* [state] */
+    int32_t*    pcs;        /* instruction sets of all states */
+    int32_t*    htab;       /* open addressing hash: state index or -1 */
+    uint32_t*   mark;       /* [ninst] generation marks */
+    int32_t*    stack;      /* [4*ninst] closure work stack */
+    int32_t*    next;       /* [2*ninst + 1] successor set */
+    int32_t     init[8];    /* initial state per flags, or -1 */
+    int         nstates, maxstates, cap, hcap, ninst, flagmask;
+    int         nsym, eov;  /* number of symbols: byte classes + end of view */
+    uint8_t     bclass[128];
+    isize       npcs, pcscap;
+    uint32_t    gen, nresets;
+    bool        report;     /* regex set: states also hold ninst + pc of each TOK_END reached */
+    catomic_isize busy;
+} _Redfa;
+
+static void
+_dfa_drop(_Redfa *d)
+{
+    if (d == NULL)
+        return;
+    i_free(d->trans, d->cap*d->nsym*c_sizeof(int32_t));
+    i_free(d->setpos, (d->cap + 1)*c_sizeof(int32_t));
+    i_free(d->flags, d->cap);
+    i_free(d->pcs, d->pcscap*c_sizeof(int32_t));
+    i_free(d->htab, d->hcap*c_sizeof(int32_t));
+    i_free(d->mark, d->ninst*c_sizeof(uint32_t));
+    i_free(d->stack, 4*d->ninst*c_sizeof(int32_t));
+    i_free(d->next, (2*d->ninst + 1)*c_sizeof(int32_t));
+    i_free(d, c_sizeof(_Redfa));
+}
+
+/* does the consuming instruction inst match rune r? fr is r casefolded if icase */
+static bool
+_dfa_match(const _Reinst *inst, _Rune r, _Rune fr)
+{
+    const _Rune *rp, *ep;
+    bool inv = false;
+    switch (inst->type) {
+    case TOK_ANY:
+        return r != '\n';
+    case TOK_ANYNL:
+        return true;
+    case TOK_NCCLASS:
+        inv = true; /* FALLTHRU */
+    case TOK_CCLASS:
+        ep = inst->r.classp->end;
+        for (rp = inst->r.classp->spans; rp < ep; rp += 2) {
+            if ((fr >= rp[0] && fr <= rp[1]) || (rp[0] == rp[1] && _runematch(rp[0], fr)))
+                break;
+        }
+        return inv ^ (rp < ep);
+    default: /* TOK_RUNE, TOK_IRUNE */
+        return _runematch(inst->r.rune, fr);
+    }
+}
+
+/* split the byte classes by whether each byte is in the set */
+static void
+_dfa_split(_Redfa *d, const bool in[128])
+{
+    int16_t id[2][128];
+    int n = 0;
+    memset(id, 0xff, sizeof id);
+    for (int b = 0; b < 128; ++b) {
+        int16_t *p = &id[in[b]][d->bclass[b]];
+        if (*p < 0) *p = (int16_t)n++;
+        d->bclass[b] = (uint8_t)*p;
+    }
+    d->eov = n, d->nsym = n + 1;
+}
+
+static void
+_dfa_byte_classes(_Redfa *d, const _Reprog *prog)
+{
+    bool in[128];
+    memset(d->bclass, 0, sizeof d->bclass);
+    for (int b = 0; b < 128; ++b) in[b] = (b == 0);
+    _dfa_split(d, in);
+    for (int b = 0; b < 128; ++b) in[b] = (b == '\n');
+    _dfa_split(d, in);
+    if (d->flagmask & _DFA_PREVWORD) {
+        for (int b = 0; b < 128; ++b) in[b] = utf8_isword((_Rune)b);
+        _dfa_split(d, in);
+    }
+    for (const _Reinst *inst = prog->firstinst; inst < prog->firstinst + prog->ninst; ++inst) {
+        switch (inst->type) {
+        case TOK_OR: case TOK_NOP: case TOK_LBRA: case TOK_RBRA: case TOK_CASED: case TOK_ICASE:
+        case TOK_BOL: case TOK_BOS: case TOK_EOL: case TOK_EOS: case TOK_WBOUND: case TOK_NWBOUND:
+        case TOK_END:
+            continue;
+        }
+        for (int b = 0; b < 128; ++b)
+            in[b] = _dfa_match(inst, (_Rune)b, prog->flags.icase ? utf8_casefold((_Rune)b) : (_Rune)b);
+        _dfa_split(d, in);
+    }
+}
+
+static _Redfa*
+_dfa_new(const _Reprog *prog)
+{
+    int flagmask = 0, ninst = prog->ninst;
+    for (const _Reinst *inst = prog->firstinst; inst < prog->firstinst + ninst; inst++) {
+        switch (inst->type) {
+            case TOK_CASED: case TOK_ICASE: /* ok if it does not change case mode */
+                if ((inst->type == TOK_ICASE) != prog->flags.icase)
+                    return NULL;
+                break;
+            case TOK_EOZ:
+                return NULL;
+            case TOK_BOL: flagmask |= _DFA_ATSTART | _DFA_PREVNL; break;
+            case TOK_BOS: flagmask |= _DFA_ATSTART; break;
+            case TOK_WBOUND: case TOK_NWBOUND:
+                flagmask |= _DFA_ATSTART | _DFA_PREVWORD; break;
+        }
+    }
+    _Redfa *d = (_Redfa *)i_malloc(c_sizeof(_Redfa));
+    if (d == NULL)
+        return NULL;
+    memset(d, 0, sizeof *d);
+    d->ninst = ninst;
+    d->maxstates = _DFA_MAXSTATES;
+    d->flagmask = flagmask;
+    d->mark = (uint32_t *)i_malloc(ninst*c_sizeof(uint32_t));
+    d->stack = (int32_t *)i_malloc(4*ninst*c_sizeof(int32_t));
+    d->next = (int32_t *)i_malloc((2*ninst + 1)*c_sizeof(int32_t));
+    if (d->mark == NULL || d->stack == NULL || d->next == NULL) {
+        _dfa_drop(d);
+        return NULL;
+    }
+    memset(d->mark, 0, (size_t)ninst*sizeof(uint32_t));
+    for (int i = 0; i < 8; ++i)
+        d->init[i] = -1;
+    _dfa_byte_classes(d, prog);
+    return d;
+}
+
+static uint32_t
+_dfa_hash(const int32_t *set, int n, int flags)
+{
+    uint32_t h = 2166136261u ^ (uint32_t)flags;
+    for (int i = 0; i < n; ++i)
+        h = (h ^ (uint32_t)set[i])*16777619u;
+    return h ^ (h >> 15);
+}
+
+static bool
+_dfa_grow(_Redfa *d)
+{
+    int cap = d->cap ? d->cap*2 : 16;
+    int32_t *trans = (int32_t *)i_realloc(d->trans, d->cap*d->nsym*c_sizeof(int32_t),
+                                                    cap*d->nsym*c_sizeof(int32_t));
+    if (trans == NULL) return false;
+    d->trans = trans;
+    int32_t *setpos = (int32_t *)i_realloc(d->setpos, (d->cap + 1)*c_sizeof(int32_t),
+                                                      (cap + 1)*c_sizeof(int32_t));
+    if (setpos == NULL) return false;
+    d->setpos = setpos;
+    uint8_t *flags = (uint8_t *)i_realloc(d->flags, d->cap, cap);
+    if (flags == NULL) return false;
+    d->flags = flags;
+    int32_t *htab = (int32_t *)i_malloc(2*cap*c_sizeof(int32_t));
+    if (htab == NULL) return false;
+    for (int i = 0; i < 2*cap; ++i)
+        htab[i] = -1;
+    for (int s = 0; s < d->nstates; ++s) {
+        const int32_t *set = d->pcs + d->setpos[s];
+        uint32_t h = _dfa_hash(set, d->setpos[s + 1] - d->setpos[s], d->flags[s]);
+        while (htab[h & (uint32_t)(2*cap - 1)] >= 0) ++h;
+        htab[h & (uint32_t)(2*cap - 1)] = s;
+    }
+    i_free(d->htab, d->hcap*c_sizeof(int32_t));
+    d->htab = htab, d->hcap = 2*cap;
+    memset(d->trans + d->cap*d->nsym, 0xff, (size_t)((cap - d->cap)*d->nsym)*sizeof(int32_t));
+    if (d->cap == 0) d->setpos[0] = 0;
+    d->cap = cap;
+    return true;
+}
+
+/* find or add the state with a sorted instruction set. return -1 on failure */
+static int
+_dfa_state(_Redfa *d, const int32_t *set, int n, int flags)
+{
+    uint32_t h = _dfa_hash(set, n, flags);
+    if (d->hcap) {
+        for (;; ++h) {
+            int s = d->htab[h & (uint32_t)(d->hcap - 1)];
+            if (s < 0) break;
+            if (d->flags[s] == flags && d->setpos[s + 1] - d->setpos[s] == n &&
+                !memcmp(d->pcs + d->setpos[s], set, (size_t)n*sizeof *set))
+                return s;
+        }
+    }
+    if (d->nstates == d->maxstates)
+        return -1;
+    if (d->nstates == d->cap) {
+        if (!_dfa_grow(d))
+            return -1;
+        h = _dfa_hash(set, n, flags);
+        while (d->htab[h & (uint32_t)(d->hcap - 1)] >= 0) ++h;
+    }
+    if (d->npcs + n > d->pcscap) {
+        isize cap = d->pcscap*2 + n + 64;
+        int32_t *pcs = (int32_t *)i_realloc(d->pcs, d->pcscap*c_sizeof(int32_t), cap*c_sizeof(int32_t));
+        if (pcs == NULL)
+            return -1;
+        d->pcs = pcs, d->pcscap = cap;
+    }
+    int s = d->nstates++;
+    memcpy(d->pcs + d->npcs, set, (size_t)n*sizeof *set);
+    d->npcs += n;
+    d->setpos[s + 1] = (int32_t)d->npcs;
+    d->flags[s] = (uint8_t)flags;
+    d->htab[h & (uint32_t)(d->hcap - 1)] = s;
+    return s;
+}
+
+static int
+_dfa_cmp_pc(const void *a, const void *b)
+{
+    return *(const int32_t *)a - *(const int32_t *)b;
+}
+
+/* clear all states, used when a regex set runs out of states */
+static void
+_dfa_reset(_Redfa *d)
+{
+    memset(d->trans, 0xff, (size_t)(d->cap*d->nsym)*sizeof(int32_t));
+    memset(d->htab, 0xff, (size_t)d->hcap*sizeof(int32_t));
+    for (int i = 0; i < 8; ++i)
+        d->init[i] = -1;
+    d->nstates = 0, d->npcs = 0;
+    ++d->nresets;
+}
+
+/*
+ *  Follow the threads of state at the current position, where the next rune is r
+ *  (sym is the byte class of r for ascii, 0 at end of string, eov at end of view,
+ *  or -1 for other runes). Threads that consume r are added to d->next. return true
+ *  if TOK_END is reached; in report mode its ninst + pc is also added to d->next.
+ */
+static bool
+_dfa_closure(_Redfa *d, const _Reprog *prog, int state, int sym, _Rune r, int *nnext_out)
+{
+    const _Reinst *base = prog->firstinst, *inst;
+    const int flags = d->flags[state];
+    const bool at_end = (sym == 0) | (sym == d->eov);
+    const bool cur_word = !at_end && utf8_isword(r);
+    const bool boundary = (flags & _DFA_ATSTART) || sym == d->eov ||
+                          (((flags & _DFA_PREVWORD) != 0) ^ cur_word);
+    _Rune fr = prog->flags.icase ? utf8_casefold(r) : r;
+    int sp = 0, nnext = 0;
+    bool matched = false, ok;
+
+    if (++d->gen == 0) {
+        memset(d->mark, 0, (size_t)d->ninst*sizeof(uint32_t));
+        d->gen = 1;
+    }
+    for (int32_t i = d->setpos[state + 1] - 1; i >= d->setpos[state]; --i)
+        d->stack[sp++] = d->pcs[i];
+
+    while (sp) {
+        int32_t pc = d->stack[--sp];
+        if (pc >= d->ninst || d->mark[pc] == d->gen) /* skip reported matches */
+            continue;
+        d->mark[pc] = d->gen;
+        inst = base + pc;
+        ok = false;
+        switch (inst->type) {
+        case TOK_OR:
+            d->stack[sp++] = (int32_t)(inst->l.left - base);
+            d->stack[sp++] = (int32_t)(inst->r.right - base);
+            continue;
+        case TOK_NOP: case TOK_LBRA: case TOK_RBRA: case TOK_CASED: case TOK_ICASE:
+            d->stack[sp++] = (int32_t)(inst->l.next - base);
+            continue;
+        case TOK_BOL:
+            if (flags & (_DFA_ATSTART | _DFA_PREVNL)) d->stack[sp++] = (int32_t)(inst->l.next - base);
+            continue;
+        case TOK_BOS:
+            if (flags & _DFA_ATSTART) d->stack[sp++] = (int32_t)(inst->l.next - base);
+            continue;
+        case TOK_EOL:
+            if (at_end || r == '\n') d->stack[sp++] = (int32_t)(inst->l.next - base);
+            continue;
+        case TOK_EOS:
+            if (at_end) d->stack[sp++] = (int32_t)(inst->l.next - base);
+            continue;
+        case TOK_NWBOUND:
+            ok = true; /* FALLTHRU */
+        case TOK_WBOUND:
+            if (ok ^ boundary) d->stack[sp++] = (int32_t)(inst->l.next - base);
+            continue;
+        case TOK_END:
+            matched = true;
+            if (d->report)
+                d->next[nnext++] = d->ninst + pc;
+            continue;
+        default:
+            ok = !at_end && _dfa_match(inst, r, fr);
+        }
+        if (ok)
+            d->next[nnext++] = (int32_t)(inst->l.next - base);
+    }
+    *nnext_out = nnext;
+    return matched;
+}
+
+/*
+ *  Compute the transition from state on rune r, see _dfa_closure(). return
+ *  next*nsym<<2 | idle<<1 | matched, or -1 when out of states. next is idle
+ *  when it only holds the thread from the start. At the end of input, return
+ *  matched, or in report mode a _DFA_ENDSET state holding the TOK_END's reached.
+ */
+static int32_t
+_dfa_step(_Redfa *d, const _Reprog *prog, int state, int sym, _Rune r)
+{
+    const _Reinst *base = prog->firstinst;
+    int nnext, next;
+    bool matched = _dfa_closure(d, prog, state, sym, r, &nnext);
+    if ((sym == 0) | (sym == d->eov)) {
+        if (!(d->report & matched))
+            return matched;
+        qsort(d->next, (size_t)nnext, sizeof *d->next, _dfa_cmp_pc);
+        int n = 0;
+        for (int i = 0; i < nnext; ++i)
+            if (d->next[i] >= d->ninst) d->next[n++] = d->next[i];
+        if ((next = _dfa_state(d, d->next, n, _DFA_ENDSET)) < 0)
+            return -1;
+        return (int32_t)next*d->nsym << 2 | 1;
+    }
+
+    /* next position: surviving threads + a new thread from the start */
+    d->next[nnext++] = (int32_t)(prog->startinst - base);
+    qsort(d->next, (size_t)nnext, sizeof *d->next, _dfa_cmp_pc);
+    int n = 0;
+    for (int i = 0; i < nnext; ++i)
+        if (i == 0 || d->next[i] != d->next[n - 1])
+            d->next[n++] = d->next[i];
+    int nflags = ((r == '\n')*_DFA_PREVNL | utf8_isword(r)*_DFA_PREVWORD) & d->flagmask;
+    next = _dfa_state(d, d->next, n, nflags);
+    if (next < 0 && d->report && d->nstates == d->maxstates) {
+        _dfa_reset(d);
+        next = _dfa_state(d, d->next, n, nflags);
+    }
+    if (next < 0)
+        return -1;
+    bool idle = (n == 1) & (d->next[0] == (int32_t)(prog->startinst - base));
+    return (int32_t)next*d->nsym << 2 | idle << 1 | matched;
+}
+
+/* initial state at position s. return -1 when out of states */
+static int
+_dfa_start(_Redfa *d, const _Reprog *prog, const char *bol, const char *s)
+{
+    int flags = ((s == bol)*_DFA_ATSTART |
+                 (s != bol && s[-1] == '\n')*_DFA_PREVNL |
+                 (s != bol && utf8_isword(_prevrune(s)))*_DFA_PREVWORD) & d->flagmask;
+    if (d->init[flags] < 0) {
+        int32_t start = (int32_t)(prog->startinst - prog->firstinst);
+        d->init[flags] = _dfa_state(d, &start, 1, flags);
+    }
+    return d->init[flags];
+}
+
+/*
+ *  return 1 if there is a match in [s, eol), 0 if not, or -1 if the DFA
+ *  can not be used: in use by another thread or out of states.
+ */
+static int
+_regexec_dfa(const _Reprog *prog, const char *bol, const char *s, const char *eol)
+{
+    _Redfa *d = prog->dfa;
+    int rv = -1, state;
+    if (c_atomic_fetch_add(&d->busy, 1) != 0) /* try-lock */
+        goto out;
+    if ((state = _dfa_start(d, prog, bol, s)) < 0)
+        goto out;
+
+    for (int32_t t = state*d->nsym << 2 | 2, row;; ) {
+        if ((t & 2) && prog->nprefix) { /* idle: skip ahead to the next prefix */
+            const char *p = _find_literal(s, eol, prog->prefix, prog->nprefix);
+            if (p == NULL) { rv = 0; goto out; }
+            if (p != s) {
+                if ((state = _dfa_start(d, prog, bol, s = p)) < 0)
+                    goto out;
+                t = state*d->nsym << 2;
+            }
+        }
+        row = t >> 2;
+        int n = 1, sym;
+        _Rune r;
+        if (s == eol) sym = d->eov, r = 0;
+        else if ((r = *(const uint8_t *)s) < 0x80) sym = d->bclass[r];
+        else sym = -1, n = chartorune(&r, s, eol);
+
+        if (sym < 0) t = _dfa_step(d, prog, row/d->nsym, sym, r);
+        else if ((t = d->trans[row + sym]) < 0) {
+            t = _dfa_step(d, prog, row/d->nsym, sym, r);
+            if (t >= 0) d->trans[row + sym] = t;
+        }
+        if (t < 0)
+            goto out;
+        if (t & 1) { rv = 1; goto out; }
+        if ((sym == 0) | (sym == d->eov)) { rv = 0; goto out; }
+        s += n;
+    }
+out:
+    c_atomic_fetch_sub(&d->busy, 1);
+    return rv;
+}
+
+
+/*
+ *  Regex set: the programs of all patterns are copied into one program, and joined
+ *  by a chain of TOK_OR. The TOK_END of each pattern holds its index in r.subid.
+ */
+static _Reprog*
+_regcomp_set(const cregex regs[], int n)
+{
+    isize ninst = n - 1;
+    for (int k = 0; k < n; ++k)
+        ninst += regs[k].prog->ninst;
+    isize allocsize = c_sizeof(_Reprog) + ninst*c_sizeof(_Reinst);
+    _Reprog *pp = (_Reprog *)i_malloc(allocsize);
+    if (pp == NULL)
+        return NULL;
+    memset(pp, 0, sizeof *pp);
+    pp->allocsize = allocsize;
+    pp->flags = regs[0].prog->flags;
+    pp->ninst = (int)ninst;
+
+    _Reinst *base = pp->firstinst + ninst, *start = NULL;
+    for (int k = n - 1; k >= 0; --k) {
+        const _Reprog *sub = regs[k].prog;
+        const _Reinst *sbase = sub->firstinst;
+        base -= sub->ninst;
+        for (int i = 0; i < sub->ninst; ++i) { /* classes stay in the pattern's program */
+            _Reinst *inst = base + i;
+            *inst = sbase[i];
+            switch (inst->type) {
+            case TOK_OR:
+            case TOK_STAR:
+            case TOK_PLUS:
+            case TOK_QUEST:
+                inst->r.right = base + (inst->r.right - sbase);
+                break;
+            case TOK_END:
+                inst->r.subid = k;
+                break;
+            }
+            if (inst->l.left)
+                inst->l.left = base + (inst->l.left - sbase);
+        }
+        _Reinst *first = base + (sub->startinst - sbase);
+        if (start) {
+            _Reinst *alt = pp->firstinst + k;
+            alt->type = TOK_OR;
+            alt->l.left = first;
+            alt->r.right = start;
+            first = alt;
+        }
+        start = first;
+    }
+    pp->startinst = start;
+    return pp;
+}
+
+/* mark the patterns of the TOK_END's reported in set. return number of new matches */
+static int
+_dfa_report(const _Redfa *d, const _Reprog *prog, const int32_t *set, int n, bool matched[])
+{
+    int count = 0;
+    for (int i = 0; i < n; ++i) {
+        if (set[i] >= d->ninst) {
+            int k = prog->firstinst[set[i] - d->ninst].r.subid;
+            count += !matched[k];
+            matched[k] = true;
+        }
+    }
+    return count;
+}
+
+/* run a set program over [s, eol). return the number of matching patterns, or -1 */
+static int
+_regexec_dfa_set(_Redfa *d, const _Reprog *prog, int npatterns,
+                 const char *bol, const char *s, const char *eol, bool matched[])
+{
+    int count = 0, state = _dfa_start(d, prog, bol, s);
+    if (state < 0)
+        return -1;
+
+    for (int32_t t, row = state*d->nsym;; row = t >> 2) {
+        int n = 1, sym;
+        _Rune r;
+        if (s == eol) sym = d->eov, r = 0;
+        else if ((r = *(const uint8_t *)s) < 0x80) sym = d->bclass[r];
+        else sym = -1, n = chartorune(&r, s, eol);
+
+        uint32_t nresets = d->nresets;
+        if (sym < 0) t = _dfa_step(d, prog, row/d->nsym, sym, r);
+        else if ((t = d->trans[row + sym]) < 0) {
+            t = _dfa_step(d, prog, row/d->nsym, sym, r);
+            if (t >= 0 && d->nresets == nresets) d->trans[row + sym] = t;
+        }
+        if (t < 0)
+            return -1;
+        if (t & 1) {
+            int next = (t >> 2)/d->nsym;
+            const int32_t *set = d->pcs + d->setpos[next];
+            count += _dfa_report(d, prog, set, d->setpos[next + 1] - d->setpos[next], matched);
+            if (count == npatterns)
+                return count;
+        }
+        if ((sym == 0) | (sym == d->eov))
+            return count;
+        s += n;
+    }
+}
+
+
 static int
 _regexec(const _Reprog *progp,    /* program to run */
     const char *bol,    /* string to run machine on */
@@ -1206,11 +1888,23 @@ _regexec(const _Reprog *progp,    /* program to run */
             j.starts = mp[0].buf + mp[0].size;
     }
 
+    rv = -1;
+    if (progp->nliteral && _find_literal(j.starts, j.eol, progp->literal, progp->nliteral) == NULL)
+        rv = 0;
+    else if (progp->dfa && !(mflags & CREG_FULLMATCH))
+        rv = _regexec_dfa(progp, bol, j.starts, j.eol);
+    if (rv == 0 && mp != NULL)
+        for (int i = 0; i < ms; i++)
+            mp[i].buf = NULL, mp[i].size = 0;
+    if (rv == 0 || (rv == 1 && mp == NULL))
+        return rv;
+
     j.starttype = 0;
     j.startchar = 0;
-    int rune_type = progp->flags.icase ? TOK_IRUNE : TOK_RUNE;
-    if (progp->startinst->type == rune_type && progp->startinst->r.rune < 128) {
-        j.starttype = rune_type;
+    if (progp->nprefix)
+        j.starttype = TOK_RUNE;
+    else if (progp->startinst->type == TOK_IRUNE && progp->startinst->r.rune < 128) {
+        j.starttype = TOK_IRUNE;
         j.startchar = progp->startinst->r.rune;
     }
     if (progp->startinst->type == TOK_BOL)
@@ -1230,6 +1924,144 @@ _regexec(const _Reprog *progp,    /* program to run */
 }
 
 
+/*
+ *  Streaming: the input is kept in a buffer from the earliest position a live thread
+ *  or the pending match starts at, and the machine runs one rune at a time as input
+ *  arrives, so the thread lists carry over between chunks. Thread and match pointers
+ *  into the buffer are rebased when it is compacted or grown.
+ */
+enum { _STREAM_BLOCK = 1<<16 };
+
+struct _Restream
+{
+    _Reljunk    j;
+    _Resub      match[_NSUBEXP]; /* best match of the current search */
+    char*       buf;        /* input from the earliest position still needed */
+    isize       size, cap;
+    isize       pos;        /* next position to run the machine on */
+    isize       offset;     /* stream offset of buf[0] */
+    bool        skip;       /* previous match was empty: skip a rune before searching */
+    bool        closed, done;
+    _Relist     relists[2*_BIGLISTSIZE];
+};
+
+static void
+_stream_restart(struct _Restream *st, const _Reprog *prog)
+{
+    st->j.flag = 0;
+    st->j.match = 0;
+    st->j.icase = prog->flags.icase;
+    st->j.eol = NULL;
+    st->relists[0].inst = NULL;
+    st->relists[_BIGLISTSIZE].inst = NULL;
+    memset(st->match, 0, sizeof st->match);
+}
+
+static struct _Restream*
+_stream_new(const _Reprog *prog)
+{
+    struct _Restream *st = (struct _Restream *)i_calloc(1, c_sizeof *st);
+    if (st == NULL)
+        return NULL;
+    st->j.relist[0] = st->relists;
+    st->j.relist[1] = st->relists + _BIGLISTSIZE;
+    st->j.reliste[0] = st->relists + _BIGLISTSIZE - 2;
+    st->j.reliste[1] = st->relists + 2*_BIGLISTSIZE - 2;
+    _stream_restart(st, prog);
+    return st;
+}
+
+/* make room for n more bytes of input. return where to put them */
+static char*
+_stream_reserve(struct _Restream *st, int ms, isize n)
+{
+    if (st->size + n < st->cap)
+        return st->buf + st->size;
+
+    /* drop the input before the earliest position still needed, but keep
+     * the rune before pos for ^ and \b */
+    isize lo = st->pos > 4 ? st->pos - 4 : 0;
+    for (const _Relist *p = st->j.relist[st->j.flag]; p->inst; ++p)
+        if (p->se.m[0].buf - st->buf < lo) lo = p->se.m[0].buf - st->buf;
+    if (st->match[0].buf && st->match[0].buf - st->buf < lo)
+        lo = st->match[0].buf - st->buf;
+
+    isize cap = st->cap, need = st->size - lo + n + 1;
+    if (need > cap/2)
+        cap = need < _STREAM_BLOCK/2 ? _STREAM_BLOCK : 2*need;
+    char *buf = cap == st->cap ? st->buf : (char *)i_malloc(cap);
+    if (buf == NULL)
+        return NULL;
+    if (st->size > lo)
+        memmove(buf, st->buf + lo, (size_t)(st->size - lo));
+
+    for (_Relist *p = st->j.relist[st->j.flag]; p->inst; ++p)
+        for (int i = 0; i < ms; ++i)
+            if (p->se.m[i].buf) p->se.m[i].buf = buf + (p->se.m[i].buf - st->buf - lo);
+    for (int i = 0; i < ms; ++i)
+        if (st->match[i].buf) st->match[i].buf = buf + (st->match[i].buf - st->buf - lo);
+
+    if (buf != st->buf)
+        i_free(st->buf, st->cap);
+    st->buf = buf;
+    st->cap = cap;
+    st->offset += lo;
+    st->size -= lo;
+    st->pos -= lo;
+    return buf + st->size;
+}
+
+/* run the machine over the buffered input until a match is complete.
+ * return 1 on match, 0 if more input is needed or at end, <0 on error */
+static int
+_stream_exec(struct _Restream *st, const _Reprog *prog, int ms)
+{
+    _Reljunk *j = &st->j;
+    const char *bol = st->offset == 0 ? st->buf : NULL;
+    const char *s, *p;
+    _Rune r;
+    int n;
+
+    for (;;) {
+        s = st->buf + st->pos;
+        if (st->pos == st->size) {
+            if (!st->closed || st->skip)
+                return 0;
+            j->eol = s; /* run the machine once at end of input */
+            if (_regstep(prog, bol, st->match, ms, j, 0, s, 0) < 0)
+                return -1;
+            st->done = (j->match == 0);
+            return j->match;
+        }
+        if (j->match == 0 && j->relist[j->flag]->inst == NULL && prog->nprefix) {
+            p = c_strnstrn(s, st->size - st->pos, prog->prefix, prog->nprefix);
+            if (p == NULL) { /* keep a partial prefix at the end */
+                if (st->pos < st->size - prog->nprefix + 1)
+                    st->pos = st->size - prog->nprefix + 1;
+                st->done = st->closed;
+                return 0;
+            }
+            s = p;
+            st->pos = s - st->buf;
+        }
+        /* need the whole rune, and the byte after it for \Z */
+        if (!st->closed && st->pos + utf8_chr_size(s) >= st->size)
+            return 0;
+        r = *(uint8_t*)s;
+        n = r < 0x80 ? 1 : chartorune(&r, s, NULL);
+        if (st->pos + n > st->size)
+            n = (int)(st->size - st->pos);
+        if (st->skip)
+            st->skip = false;
+        else if (_regstep(prog, bol, st->match, ms, j, 0, s, r) < 0)
+            return -1;
+        st->pos += n;
+        if (j->match && j->relist[j->flag]->inst == NULL)
+            return 1;
+    }
+}
+
+
 static void
 _build_substitution(const char* replace, int nmatch, const csview match[],
                     bool(*transform)(int, csview, cstr*), cstr* subst) {
@@ -1275,7 +2107,11 @@ _build_substitution(const char* replace, int nmatch, const csview match[],
 int
 cregex_compile_pro(cregex *self, const char* pattern, int cflags) {
     _Parser par;
+    if (self->prog)
+        _dfa_drop(self->prog->dfa);
     self->prog = _regcomp1(self->prog, &par, pattern, cflags);
+    if (self->prog)
+        self->prog->dfa = _dfa_new(self->prog);
     return self->error = par.error;
 }
 
@@ -1338,7 +2174,174 @@ cregex_replace_aio_pro(const char* pattern, csview input, const char* replace,
 
 void
 cregex_drop(cregex* self) {
-    i_free(self->prog, self->prog->allocsize);
+    if (self->prog) {
+        _dfa_drop(self->prog->dfa);
+        i_free(self->prog, self->prog->allocsize);
+    }
+}
+
+int
+cregex_set_compile(cregex_set* self, const char* patterns[], int n, int cflags) {
+    cregex_set_drop(self);
+    self->regex = (cregex *)i_calloc(n > 0 ? n : 1, c_sizeof(cregex));
+    if (self->regex == NULL)
+        return self->error = CREG_OUTOFMEMORY;
+    self->count = n;
+    for (int k = 0; k < n; ++k)
+        if (cregex_compile_pro(&self->regex[k], patterns[k], cflags) != CREG_OK)
+            return self->error = self->regex[k].error;
+    if (n == 0)
+        return self->error = CREG_OK;
+    if ((self->prog = _regcomp_set(self->regex, n)) == NULL)
+        return self->error = CREG_OUTOFMEMORY;
+    if ((self->prog->dfa = _dfa_new(self->prog)) != NULL)
+        self->prog->dfa->report = true, self->prog->dfa->maxstates = _DFA_MAXSTATES_SET;
+    return self->error = CREG_OK;
+}
+
+static int
+_cregex_set_match(const cregex_set* self, const char* input, const char* eol, bool matched[]) {
+    for (int k = 0; k < self->count; ++k)
+        matched[k] = false;
+    if (self->count == 0)
+        return 0;
+    if (self->prog == NULL)
+        return CREG_MATCHERROR;
+
+    _Redfa *d = self->prog->dfa, *tmp = NULL;
+    if (d && c_atomic_fetch_add(&d->busy, 1) != 0) { /* in use: run on a private dfa */
+        c_atomic_fetch_sub(&d->busy, 1);
+        if ((d = tmp = _dfa_new(self->prog)) != NULL)
+            d->report = true, d->maxstates = _DFA_MAXSTATES_SET;
+    }
+    int count = d ? _regexec_dfa_set(d, self->prog, self->count, input, input, eol, matched) : -1;
+    if (tmp) _dfa_drop(tmp);
+    else if (d) c_atomic_fetch_sub(&d->busy, 1);
+
+    if (count < 0) { /* no dfa for these patterns: match them one by one */
+        csview m[CREG_MAX_CAPTURES];
+        count = 0;
+        for (int k = 0; k < self->count; ++k) {
+            m[0] = c_sv(input, eol ? eol - input : 0);
+            int res = cregex_match_pro(&self->regex[k], input, eol ? m : NULL,
+                                       eol ? CREG_STARTEND : CREG_DEFAULT);
+            if (res == CREG_MATCHERROR)
+                return res;
+            count += (matched[k] = (res == CREG_OK));
+        }
+    }
+    return count;
+}
+
+int
+cregex_set_match(const cregex_set* self, const char* input, bool matched[]) {
+    return _cregex_set_match(self, input, NULL, matched);
+}
+
+int
+cregex_set_match_sv(const cregex_set* self, csview input, bool matched[]) {
+    return _cregex_set_match(self, input.buf, input.buf + input.size, matched);
+}
+
+void
+cregex_set_drop(cregex_set* self) {
+    for (int k = 0; k < self->count; ++k)
+        cregex_drop(&self->regex[k]);
+    if (self->prog) {
+        _dfa_drop(self->prog->dfa);
+        i_free(self->prog, self->prog->allocsize);
+    }
+    i_free(self->regex, (self->count > 0 ? self->count : 1)*c_sizeof(cregex));
+    self->regex = NULL, self->prog = NULL;
+    self->count = 0;
+}
+
+static struct _Restream*
+_cregex_stream_state(cregex_stream* self) {
+    if (self->state == NULL)
+        self->state = _stream_new(self->regex->prog);
+    return self->state;
+}
+
+int
+cregex_stream_feed(cregex_stream* self, csview chunk) {
+    struct _Restream *st = _cregex_stream_state(self);
+    if (st == NULL)
+        return CREG_OUTOFMEMORY;
+    if (st->closed)
+        return CREG_MATCHERROR;
+    char *dst = _stream_reserve(st, cregex_captures(self->regex) + 1, chunk.size);
+    if (dst == NULL)
+        return CREG_OUTOFMEMORY;
+    c_memcpy(dst, chunk.buf, chunk.size);
+    st->buf[st->size += chunk.size] = '\0';
+    return CREG_OK;
+}
+
+int
+cregex_stream_close(cregex_stream* self) {
+    struct _Restream *st = _cregex_stream_state(self);
+    if (st == NULL)
+        return CREG_OUTOFMEMORY;
+    if (st->buf == NULL && _stream_reserve(st, 1, 0) == NULL)
+        return CREG_OUTOFMEMORY;
+    st->buf[st->size] = '\0';
+    st->closed = true;
+    return CREG_OK;
+}
+
+int
+cregex_stream_next(cregex_stream* self, csview match[]) {
+    struct _Restream *st = self->state;
+    if (st == NULL || st->done)
+        return CREG_NOMATCH;
+    const _Reprog *prog = self->regex->prog;
+    int ms = cregex_captures(self->regex) + 1;
+
+    switch (_stream_exec(st, prog, ms)) {
+        case 0: return CREG_NOMATCH;
+        case 1: break;
+        default: return CREG_MATCHERROR;
+    }
+    for (int i = 0; i < ms; ++i)
+        match[i] = st->match[i];
+    /* search on from the end of the match */
+    st->pos = (match[0].buf - st->buf) + match[0].size;
+    st->skip = (match[0].size == 0);
+    _stream_restart(st, prog);
+    return CREG_OK;
+}
+
+int
+cregex_stream_next_file(cregex_stream* self, FILE* fp, csview match[]) {
+    int res;
+    if (_cregex_stream_state(self) == NULL)
+        return CREG_OUTOFMEMORY;
+    while ((res = cregex_stream_next(self, match)) == CREG_NOMATCH && !self->state->closed) {
+        char *dst = _stream_reserve(self->state, cregex_captures(self->regex) + 1, _STREAM_BLOCK);
+        if (dst == NULL)
+            return CREG_OUTOFMEMORY;
+        size_t n = fread(dst, 1, _STREAM_BLOCK, fp);
+        if (n == 0)
+            cregex_stream_close(self);
+        else
+            self->state->buf[self->state->size += (isize)n] = '\0';
+    }
+    return res;
+}
+
+isize
+cregex_stream_offset(const cregex_stream* self, const char* pos) {
+    return self->state->offset + (pos - self->state->buf);
+}
+
+void
+cregex_stream_drop(cregex_stream* self) {
+    if (self->state) {
+        i_free(self->state->buf, self->state->cap);
+        i_free(self->state, c_sizeof *self->state);
+    }
+    self->state = NULL;
 }
 
 #endif // STC_CREGEX_PRV_C_INCLUDED
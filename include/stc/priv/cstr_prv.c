@@ -259,12 +259,20 @@ fn_tocase[] = {{toLower, utf8_casefold},
 
 cstr cstr_tocase_sv(csview sv, int k) {
     cstr out = {0};
-    char *buf = cstr_reserve(&out, sv.size*3/2);
-    isize sz = 0;
+    isize sz = 0, cap = sv.size*3/2;
+    char *buf = cstr_reserve(&out, cap);
     utf8_decode_t d = {.state=0};
     const char* end = sv.buf + sv.size;
 
     while (sv.buf < end) {
+        const isize n = _utf8_tocase_ascii(buf + sz, sv.buf, end - sv.buf, k == 2);
+        sz += n, sv.buf += n;
+        if (sv.buf == end)
+            break;
+        if (cap - sz < (end - sv.buf) + 4) { // invalid bytes expand to a 3-byte U+FFFD
+            _cstr_set_size(&out, sz);
+            buf = cstr_reserve(&out, cap = sz + (end - sv.buf)*3/2 + 4);
+        }
         sv.buf += utf8_decode_codepoint(&d, sv.buf, end);
 
         if (d.codep < 0x80)
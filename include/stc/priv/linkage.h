@@ -45,7 +45,12 @@
 #elif !defined i_allocator
   #define i_allocator c
 #endif
-#ifndef i_malloc
+#if !defined i_malloc && defined i_allocator_ctx // stateful: container holds an i_allocator* alloc
+  #define i_malloc(sz) c_JOIN(i_allocator, _malloc)(self->alloc, sz)
+  #define i_calloc(n, sz) c_JOIN(i_allocator, _calloc)(self->alloc, n, sz)
+  #define i_realloc(p, old_sz, sz) c_JOIN(i_allocator, _realloc)(self->alloc, p, old_sz, sz)
+  #define i_free(p, sz) c_JOIN(i_allocator, _free)(self->alloc, p, sz)
+#elif !defined i_malloc
   #define i_malloc c_JOIN(i_allocator, _malloc)
   #define i_calloc c_JOIN(i_allocator, _calloc)
   #define i_realloc c_JOIN(i_allocator, _realloc)
@@ -28,6 +28,8 @@
 #undef i_free
 #undef i_aux
 #undef _i_aux_struct
+#undef i_allocator_ctx
+#undef _i_alloc_struct
 
 #undef i_static
 #undef i_header
@@ -224,8 +224,9 @@ _c_MEMB(_shrink_to_fit)(Self *self) {
     isize sz = _c_MEMB(_size)(self), j = 0;
     if (sz > self->capmask/2)
         return;
-    Self out = _c_MEMB(_with_capacity)(sz);
-    if (out.cbuf == NULL)
+    Self out = *self;
+    out.cbuf = NULL, out.start = out.end = out.capmask = 0;
+    if (!_c_MEMB(_reserve)(&out, sz))
         return;
     for (c_each(i, Self, *self))
         out.cbuf[j++] = *i.ref;
@@ -238,8 +239,9 @@ _c_MEMB(_shrink_to_fit)(Self *self) {
 STC_DEF Self
 _c_MEMB(_clone)(Self q) {
     isize sz = _c_MEMB(_size)(&q), j = 0;
-    Self tmp = _c_MEMB(_with_capacity)(sz);
-    if (tmp.cbuf)
+    Self tmp = q; // keeps aux and allocator context
+    tmp.cbuf = NULL, tmp.start = tmp.end = tmp.capmask = 0;
+    if (_c_MEMB(_reserve)(&tmp, sz))
         for (c_each(i, Self, q))
             tmp.cbuf[j++] = i_keyclone((*i.ref));
     q.cbuf = tmp.cbuf;
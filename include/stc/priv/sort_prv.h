@@ -30,14 +30,59 @@
   #define i_at_mut(self, idx) _c_MEMB(_at_mut)(self, idx)
 #endif
 
+#ifndef STC_SORT_PRV_H_INCLUDED
+#define STC_SORT_PRV_H_INCLUDED
+  #ifdef STC_HAS_THREADS
+    #include <threads.h>
+  #endif
+
+  // Radix keys for i_radix_key: map signed integers and floating point
+  // numbers to unsigned integers with the same ordering.
+  #define c_radix_signed(x) \
+    (((uint64_t)(x) ^ ((uint64_t)1 << (sizeof(x)*8 - 1))) & (~(uint64_t)0 >> (64 - sizeof(x)*8)))
+  #define c_radix_float(x) \
+    (sizeof(x) == sizeof(float) ? _c_radix_f32((float)(x)) : _c_radix_f64((double)(x)))
+
+  STC_INLINE uint64_t _c_radix_f32(float x) {
+      uint32_t u; memcpy(&u, &x, 4);
+      return u >> 31 ? ~u : u | 0x80000000;
+  }
+  STC_INLINE uint64_t _c_radix_f64(double x) {
+      uint64_t u; memcpy(&u, &x, 8);
+      return u >> 63 ? ~u : u | ((uint64_t)1 << 63);
+  }
+#endif // STC_SORT_PRV_H_INCLUDED
+
 STC_API void _c_MEMB(_sort_lowhigh)(Self* self, isize lo, isize hi);
+#ifndef _i_is_list
+STC_API void _c_MEMB(_sort_parallel_lowhigh)(Self* self, isize lo, isize hi, int nthreads);
+#endif
+#if defined i_radix_key && !defined _i_is_list
+STC_API bool _c_MEMB(_radix_sort_lowhigh)(Self* self, isize lo, isize hi);
+STC_API void _c_MEMB(_insertsort_lowhigh)(Self* self, isize lo, isize hi);
+enum { _c_MEMB(_radix_min_) = 128 }; // below this size, comparison sorting is faster
+#endif
 
 #ifdef _i_is_array
 STC_API isize _c_MEMB(_lower_bound_range)(const Self* self, const _m_raw raw, isize start, isize end);
 STC_API isize _c_MEMB(_binary_search_range)(const Self* self, const _m_raw raw, isize start, isize end);
 
-static inline void _c_MEMB(_sort)(Self* arr, isize n)
-    { _c_MEMB(_sort_lowhigh)(arr, 0, n - 1); }
+static inline void _c_MEMB(_sort)(Self* arr, isize n) {
+  #ifdef i_radix_key
+    if (n >= _c_MEMB(_radix_min_) && _c_MEMB(_radix_sort_lowhigh)(arr, 0, n - 1)) return;
+  #endif
+    _c_MEMB(_sort_lowhigh)(arr, 0, n - 1);
+}
+
+#ifdef i_radix_key
+static inline void _c_MEMB(_sort_stable)(Self* arr, isize n) {
+    if (n < _c_MEMB(_radix_min_) || !_c_MEMB(_radix_sort_lowhigh)(arr, 0, n - 1))
+        _c_MEMB(_insertsort_lowhigh)(arr, 0, n - 1);
+}
+#endif
+
+static inline void _c_MEMB(_sort_parallel)(Self* arr, isize n, int nthreads)
+    { _c_MEMB(_sort_parallel_lowhigh)(arr, 0, n - 1, nthreads); }
 
 static inline isize // c_NPOS = not found
 _c_MEMB(_lower_bound)(const Self* arr, const _m_raw raw, isize n)
@@ -51,8 +96,24 @@ _c_MEMB(_binary_search)(const Self* arr, const _m_raw raw, isize n)
 STC_API isize _c_MEMB(_lower_bound_range)(const Self* self, const _m_raw raw, isize start, isize end);
 STC_API isize _c_MEMB(_binary_search_range)(const Self* self, const _m_raw raw, isize start, isize end);
 
-static inline void _c_MEMB(_sort)(Self* self)
-    { _c_MEMB(_sort_lowhigh)(self, 0, _c_MEMB(_size)(self) - 1); }
+static inline void _c_MEMB(_sort)(Self* self) {
+    const isize n = _c_MEMB(_size)(self);
+  #ifdef i_radix_key
+    if (n >= _c_MEMB(_radix_min_) && _c_MEMB(_radix_sort_lowhigh)(self, 0, n - 1)) return;
+  #endif
+    _c_MEMB(_sort_lowhigh)(self, 0, n - 1);
+}
+
+#ifdef i_radix_key
+static inline void _c_MEMB(_sort_stable)(Self* self) {
+    const isize n = _c_MEMB(_size)(self);
+    if (n < _c_MEMB(_radix_min_) || !_c_MEMB(_radix_sort_lowhigh)(self, 0, n - 1))
+        _c_MEMB(_insertsort_lowhigh)(self, 0, n - 1);
+}
+#endif
+
+static inline void _c_MEMB(_sort_parallel)(Self* self, int nthreads)
+    { _c_MEMB(_sort_parallel_lowhigh)(self, 0, _c_MEMB(_size)(self) - 1, nthreads); }
 
 static inline isize // c_NPOS = not found
 _c_MEMB(_lower_bound)(const Self* self, const _m_raw raw)
@@ -66,7 +127,12 @@ _c_MEMB(_binary_search)(const Self* self, const _m_raw raw)
 /* -------------------------- IMPLEMENTATION ------------------------- */
 #if defined i_implement
 
-static void _c_MEMB(_insertsort_lowhigh)(Self* self, isize lo, isize hi) {
+#if !defined i_radix_key || defined _i_is_list
+static
+#else
+STC_DEF
+#endif
+void _c_MEMB(_insertsort_lowhigh)(Self* self, isize lo, isize hi) {
     for (isize j = lo, i = lo + 1; i <= hi; j = i, ++i) {
         _m_value x = *i_at(self, i);
         _m_raw rx = i_keytoraw((&x));
@@ -80,19 +146,24 @@ static void _c_MEMB(_insertsort_lowhigh)(Self* self, isize lo, isize hi) {
     }
 }
 
+// Partition [lo, hi] so that [lo, *jp] <= pivot <= [*ip, hi].
+static inline void _c_MEMB(_partition_)(Self* self, isize lo, isize hi, isize* ip, isize* jp) {
+    isize i = lo, j = hi;
+    _m_raw pivot = i_keytoraw(i_at(self, (isize)(lo + (hi - lo)*7LL/16))), rx;
+    do {
+        do { rx = i_keytoraw(i_at(self, i)); } while ((i_less((&rx), (&pivot))) && ++i);
+        do { rx = i_keytoraw(i_at(self, j)); } while ((i_less((&pivot), (&rx))) && --j);
+        if (i > j) break;
+        c_swap(i_at_mut(self, i), i_at_mut(self, j));
+        ++i; --j;
+    } while (i <= j);
+    *ip = i, *jp = j;
+}
+
 STC_DEF void _c_MEMB(_sort_lowhigh)(Self* self, isize lo, isize hi) {
-    isize i = lo, j;
+    isize i, j;
     while (lo < hi) {
-        _m_raw pivot = i_keytoraw(i_at(self, (isize)(lo + (hi - lo)*7LL/16))), rx;
-        j = hi;
-        do {
-            do { rx = i_keytoraw(i_at(self, i)); } while ((i_less((&rx), (&pivot))) && ++i);
-            do { rx = i_keytoraw(i_at(self, j)); } while ((i_less((&pivot), (&rx))) && --j);
-            if (i > j) break;
-            c_swap(i_at_mut(self, i), i_at_mut(self, j));
-            ++i; --j;
-        } while (i <= j);
-
+        _c_MEMB(_partition_)(self, lo, hi, &i, &j);
         if (j - lo > hi - i) {
             c_swap(&lo, &i);
             c_swap(&hi, &j);
@@ -103,6 +174,97 @@ STC_DEF void _c_MEMB(_sort_lowhigh)(Self* self, isize lo, isize hi) {
     }
 }
 
+#ifndef _i_is_list
+#ifdef STC_HAS_THREADS
+struct _c_MEMB(_sort_task_) { Self* self; isize lo, hi; int nthreads; };
+
+static int _c_MEMB(_sort_task_run_)(void* arg) {
+    struct _c_MEMB(_sort_task_)* t = (struct _c_MEMB(_sort_task_)*)arg;
+    _c_MEMB(_sort_parallel_lowhigh)(t->self, t->lo, t->hi, t->nthreads);
+    return 0;
+}
+#endif
+
+// Task parallel quicksort: each partition step hands the left part to a new thread,
+// along with a share of the threads proportional to its size.
+STC_DEF void _c_MEMB(_sort_parallel_lowhigh)(Self* self, isize lo, isize hi, int nthreads) {
+#ifdef STC_HAS_THREADS
+    enum {min_part = 1<<14}; // smaller parts are not worth a thread
+    while (nthreads > 1 && hi - lo >= 2*min_part) {
+        isize i, j;
+        _c_MEMB(_partition_)(self, lo, hi, &i, &j);
+        const isize nleft = j - lo + 1, nright = hi - i + 1;
+        if (nleft < min_part) {
+            if (j > lo) _c_MEMB(_sort_lowhigh)(self, lo, j);
+            lo = i;
+        } else if (nright < min_part) {
+            if (hi > i) _c_MEMB(_sort_lowhigh)(self, i, hi);
+            hi = j;
+        } else {
+            int tleft = (int)((double)nthreads*(double)nleft/(double)(nleft + nright) + 0.5);
+            tleft = tleft < 1 ? 1 : tleft > nthreads - 1 ? nthreads - 1 : tleft;
+            struct _c_MEMB(_sort_task_) task = {self, lo, j, tleft};
+            thrd_t thread;
+            if (thrd_create(&thread, _c_MEMB(_sort_task_run_), &task) != thrd_success) {
+                _c_MEMB(_sort_lowhigh)(self, lo, j);
+                tleft = 0;
+            }
+            _c_MEMB(_sort_parallel_lowhigh)(self, i, hi, nthreads - tleft);
+            if (tleft) thrd_join(thread, NULL);
+            return;
+        }
+    }
+#else
+    (void)nthreads;
+#endif
+    _c_MEMB(_sort_lowhigh)(self, lo, hi);
+}
+#endif // !_i_is_list
+
+#if defined i_radix_key && !defined _i_is_list
+// Stable LSD radix sort on the 64-bit i_radix_key, one byte per pass. Passes where all
+// keys have the same byte are skipped. Returns false if the buffer allocation fails.
+STC_DEF bool _c_MEMB(_radix_sort_lowhigh)(Self* self, isize lo, isize hi) {
+    const isize n = hi - lo + 1;
+    if (n < 2) return true;
+    _m_value* tmp = _i_malloc(_m_value, n);
+    if (tmp == NULL) return false;
+
+    isize count[8][256] = {{0}};
+    const uint64_t first = i_radix_key(i_at(self, lo));
+    for (isize i = lo; i <= hi; ++i) {
+        const uint64_t key = i_radix_key(i_at(self, i));
+        for (int b = 0; b < 8; ++b) ++count[b][(key >> 8*b) & 255];
+    }
+
+    bool in_tmp = false;
+    for (int b = 0; b < 8; ++b) {
+        isize* pos = count[b], sum = 0;
+        if (pos[(first >> 8*b) & 255] == n) continue;
+        for (int d = 0; d < 256; ++d) {
+            const isize c = pos[d];
+            pos[d] = sum, sum += c;
+        }
+        if (in_tmp) {
+            for (isize i = 0; i < n; ++i) {
+                const uint64_t key = i_radix_key((tmp + i));
+                *i_at_mut(self, lo + pos[(key >> 8*b) & 255]++) = tmp[i];
+            }
+        } else {
+            for (isize i = lo; i <= hi; ++i) {
+                const uint64_t key = i_radix_key(i_at(self, i));
+                tmp[pos[(key >> 8*b) & 255]++] = *i_at(self, i);
+            }
+        }
+        in_tmp = !in_tmp;
+    }
+    if (in_tmp)
+        for (isize i = 0; i < n; ++i) *i_at_mut(self, lo + i) = tmp[i];
+    i_free(tmp, n*c_sizeof *tmp);
+    return true;
+}
+#endif // i_radix_key
+
 #ifndef _i_is_list
 STC_DEF isize // c_NPOS = not found
 _c_MEMB(_lower_bound_range)(const Self* self, const _m_raw raw, isize start, isize end) {
@@ -51,6 +51,12 @@
   #define c_valclass      (1<<9)
   #define c_keypro        (1<<10)
   #define c_valpro        (1<<11)
+
+  // In #if: whether a resolved i_keydrop, i_keyclone, ... is the default for plain values.
+  #define _c_is_default(f) c_JOIN(_c_default_, f)
+  #define _c_default_c_default_clone 1
+  #define _c_default_c_default_toraw 1
+  #define _c_default_c_default_drop 1
 #endif
 
 #if defined i_rawclass   // [deprecated]
@@ -72,7 +78,9 @@
 #endif
 
 #if defined i_type && c_NUMARGS(i_type) > 1
-  #define Self c_GETARG(1, i_type)
+  #ifndef Self
+    #define Self c_GETARG(1, i_type)
+  #endif
   #define i_key c_GETARG(2, i_type)
   #if c_NUMARGS(i_type) == 3
     #if defined _i_is_map
@@ -305,5 +313,12 @@
 #ifndef i_valraw
   #define i_valraw i_keyraw
 #endif
+// Snapshots store the elements bitwise, see csnap.h. Checked here, where e.g. c_keypro in
+// i_type has been resolved into i_keydrop, etc.
+#if defined i_snapshot && !(_c_is_default(i_keydrop) && _c_is_default(i_keyclone))
+  #error "i_snapshot requires POD keys and values"
+#elif defined i_snapshot && defined _i_is_map && !(_c_is_default(i_valdrop) && _c_is_default(i_valclone))
+  #error "i_snapshot requires POD keys and values"
+#endif
 #undef _i_rawclass_is_key
 #endif // STC_TEMPLATE_H_INCLUDED
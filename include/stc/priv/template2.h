@@ -44,6 +44,7 @@
 #undef i_less
 #undef i_eq
 #undef i_hash
+#undef i_radix_key
 
 #undef i_val
 #undef i_valpro     // Replaces next two
@@ -70,21 +70,214 @@ uint32_t utf8_peek_at(const char* s, isize offset) {
     return utf8_peek(utf8_offset(s, offset));
 }
 
+/* Vectorized validation by the lookup algorithm of Keiser and Lemire, "Validating UTF-8 In
+ * Less Than One Instruction Per Byte": three table lookups on the nibbles of each byte and
+ * the byte before it flag the errors in each pair of bytes; the number of continuation bytes
+ * after 3- and 4-byte leads is checked separately. Blocks of ascii are skipped. */
+#if defined __SSSE3__
+  #include <tmmintrin.h>
+  #define _utf8_SSSE3
+#elif defined __ARM_NEON && defined __aarch64__
+  #include <arm_neon.h>
+  #define _utf8_NEON
+#endif
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define _utf8_SSE2
+#endif
+
+#if defined _utf8_SSSE3 || defined _utf8_NEON
+enum {
+    _u8_TOO_SHORT = 1<<0,   /* 11______ 0_______, 11______ 11______ */
+    _u8_TOO_LONG = 1<<1,    /* 0_______ 10______ */
+    _u8_OVERLONG_3 = 1<<2,  /* 11100000 100_____ */
+    _u8_TOO_LARGE = 1<<3,   /* 11110100 1001____, 11110100 101_____, 11110101+ 10______ */
+    _u8_SURROGATE = 1<<4,   /* 11101101 101_____ */
+    _u8_OVERLONG_2 = 1<<5,  /* 1100000_ 10______ */
+    _u8_TOO_LARGE_1000 = 1<<6, /* 11110101+ 1000____ */
+    _u8_OVERLONG_4 = 1<<6,  /* 11110000 1000____ */
+    _u8_TWO_CONTS = 1<<7,   /* 10______ 10______ */
+    _u8_CARRY = _u8_TOO_SHORT | _u8_TOO_LONG | _u8_TWO_CONTS,
+};
+
+static const uint8_t _utf8_vtab[3][16] = {
+    { /* high nibble of previous byte */
+        _u8_TOO_LONG, _u8_TOO_LONG, _u8_TOO_LONG, _u8_TOO_LONG,
+        _u8_TOO_LONG, _u8_TOO_LONG, _u8_TOO_LONG, _u8_TOO_LONG,
+        _u8_TWO_CONTS, _u8_TWO_CONTS, _u8_TWO_CONTS, _u8_TWO_CONTS,
+        _u8_TOO_SHORT | _u8_OVERLONG_2,
+        _u8_TOO_SHORT,
+        _u8_TOO_SHORT | _u8_OVERLONG_3 | _u8_SURROGATE,
+        _u8_TOO_SHORT | _u8_TOO_LARGE | _u8_TOO_LARGE_1000 | _u8_OVERLONG_4,
+    }, { /* low nibble of previous byte */
+        _u8_CARRY | _u8_OVERLONG_3 | _u8_OVERLONG_2 | _u8_OVERLONG_4,
+        _u8_CARRY | _u8_OVERLONG_2,
+        _u8_CARRY,
+        _u8_CARRY,
+        _u8_CARRY | _u8_TOO_LARGE,
+        _u8_CARRY | _u8_TOO_LARGE | _u8_TOO_LARGE_1000,
+        _u8_CARRY | _u8_TOO_LARGE | _u8_TOO_LARGE_1000,
+        _u8_CARRY | _u8_TOO_LARGE | _u8_TOO_LARGE_1000,
+        _u8_CARRY | _u8_TOO_LARGE | _u8_TOO_LARGE_1000,
+        _u8_CARRY | _u8_TOO_LARGE | _u8_TOO_LARGE_1000,
+        _u8_CARRY | _u8_TOO_LARGE | _u8_TOO_LARGE_1000,
+        _u8_CARRY | _u8_TOO_LARGE | _u8_TOO_LARGE_1000,
+        _u8_CARRY | _u8_TOO_LARGE | _u8_TOO_LARGE_1000,
+        _u8_CARRY | _u8_TOO_LARGE | _u8_TOO_LARGE_1000 | _u8_SURROGATE,
+        _u8_CARRY | _u8_TOO_LARGE | _u8_TOO_LARGE_1000,
+        _u8_CARRY | _u8_TOO_LARGE | _u8_TOO_LARGE_1000,
+    }, { /* high nibble of byte */
+        _u8_TOO_SHORT, _u8_TOO_SHORT, _u8_TOO_SHORT, _u8_TOO_SHORT,
+        _u8_TOO_SHORT, _u8_TOO_SHORT, _u8_TOO_SHORT, _u8_TOO_SHORT,
+        _u8_TOO_LONG | _u8_OVERLONG_2 | _u8_TWO_CONTS | _u8_OVERLONG_3 | _u8_TOO_LARGE_1000 | _u8_OVERLONG_4,
+        _u8_TOO_LONG | _u8_OVERLONG_2 | _u8_TWO_CONTS | _u8_OVERLONG_3 | _u8_TOO_LARGE,
+        _u8_TOO_LONG | _u8_OVERLONG_2 | _u8_TWO_CONTS | _u8_SURROGATE | _u8_TOO_LARGE,
+        _u8_TOO_LONG | _u8_OVERLONG_2 | _u8_TWO_CONTS | _u8_SURROGATE | _u8_TOO_LARGE,
+        _u8_TOO_SHORT, _u8_TOO_SHORT, _u8_TOO_SHORT, _u8_TOO_SHORT,
+    },
+};
+/* bytes above these at the end of a block start a sequence that continues in the next */
+static const uint8_t _utf8_vmax[16] = {
+    255,255,255,255,255,255,255,255,255,255,255,255,255, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+};
+#endif
+
+/* validate the 16-byte blocks of s, up to a block holding a NUL. return the offset
+ * the scalar decoder continues from, or -1 on error */
+static isize _utf8_valid_blocks(const char* s, isize nbytes) {
+    isize i = 0;
+  #if defined _utf8_SSSE3
+    const __m128i t1 = _mm_loadu_si128((const __m128i*)_utf8_vtab[0]);
+    const __m128i t2 = _mm_loadu_si128((const __m128i*)_utf8_vtab[1]);
+    const __m128i t3 = _mm_loadu_si128((const __m128i*)_utf8_vtab[2]);
+    const __m128i max = _mm_loadu_si128((const __m128i*)_utf8_vmax);
+    const __m128i nib = _mm_set1_epi8(0x0F), zero = _mm_setzero_si128();
+    __m128i prev = zero, err = zero, incomplete = zero;
+    for (; nbytes - i >= 16; i += 16) {
+        const __m128i in = _mm_loadu_si128((const __m128i*)(s + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(in, zero)))
+            break;
+        if (_mm_movemask_epi8(in) == 0) { /* ascii */
+            err = _mm_or_si128(err, incomplete);
+            incomplete = zero;
+            prev = in;
+            continue;
+        }
+        const __m128i p1 = _mm_alignr_epi8(in, prev, 15);
+        const __m128i sc = _mm_and_si128(_mm_and_si128(
+            _mm_shuffle_epi8(t1, _mm_and_si128(_mm_srli_epi16(p1, 4), nib)),
+            _mm_shuffle_epi8(t2, _mm_and_si128(p1, nib))),
+            _mm_shuffle_epi8(t3, _mm_and_si128(_mm_srli_epi16(in, 4), nib)));
+        const __m128i must23 = _mm_or_si128(
+            _mm_subs_epu8(_mm_alignr_epi8(in, prev, 14), _mm_set1_epi8(0xE0 - 0x80)),
+            _mm_subs_epu8(_mm_alignr_epi8(in, prev, 13), _mm_set1_epi8(0xF0 - 0x80)));
+        err = _mm_or_si128(err, _mm_xor_si128(_mm_and_si128(must23, _mm_set1_epi8((char)0x80)), sc));
+        incomplete = _mm_subs_epu8(in, max);
+        prev = in;
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(err, zero)) != 0xFFFF)
+        return -1;
+  #elif defined _utf8_NEON
+    const uint8x16_t t1 = vld1q_u8(_utf8_vtab[0]), t2 = vld1q_u8(_utf8_vtab[1]);
+    const uint8x16_t t3 = vld1q_u8(_utf8_vtab[2]), max = vld1q_u8(_utf8_vmax);
+    const uint8x16_t nib = vdupq_n_u8(0x0F), zero = vdupq_n_u8(0);
+    uint8x16_t prev = zero, err = zero, incomplete = zero;
+    for (; nbytes - i >= 16; i += 16) {
+        const uint8x16_t in = vld1q_u8((const uint8_t*)s + i);
+        if (vminvq_u8(in) == 0)
+            break;
+        if (vmaxvq_u8(in) < 0x80) { /* ascii */
+            err = vorrq_u8(err, incomplete);
+            incomplete = zero;
+            prev = in;
+            continue;
+        }
+        const uint8x16_t p1 = vextq_u8(prev, in, 15);
+        const uint8x16_t sc = vandq_u8(vandq_u8(vqtbl1q_u8(t1, vshrq_n_u8(p1, 4)),
+                                                vqtbl1q_u8(t2, vandq_u8(p1, nib))),
+                                                vqtbl1q_u8(t3, vshrq_n_u8(in, 4)));
+        const uint8x16_t must23 = vorrq_u8(vqsubq_u8(vextq_u8(prev, in, 14), vdupq_n_u8(0xE0 - 0x80)),
+                                           vqsubq_u8(vextq_u8(prev, in, 13), vdupq_n_u8(0xF0 - 0x80)));
+        err = vorrq_u8(err, veorq_u8(vandq_u8(must23, vdupq_n_u8(0x80)), sc));
+        incomplete = vqsubq_u8(in, max);
+        prev = in;
+    }
+    if (vmaxvq_u8(err) != 0)
+        return -1;
+  #else
+    (void)nbytes;
+  #endif
+    if (i > 0) { /* continue from the lead byte of a sequence that may be split */
+        isize j = i;
+        while ((j > i - 3) & ((s[j - 1] & 0xC0) == 0x80))
+            --j;
+        if ((uint8_t)s[j - 1] >= 0xC0)
+            i = j - 1;
+    }
+    return i;
+}
+
+/* 8 ascii bytes, none NUL */
+static inline bool _utf8_ascii8(const char* s) {
+    uint64_t w;
+    memcpy(&w, s, 8);
+    return ((w | ((w - 0x0101010101010101) & ~w)) & 0x8080808080808080) == 0;
+}
+
 bool utf8_valid(const char* s) {
-    utf8_decode_t d = {.state=0};
-    while ((utf8_decode(&d, (uint8_t)*s) != utf8_REJECT) & (*s != '\0'))
-        ++s;
-    return d.state == utf8_ACCEPT;
+    return utf8_valid_n(s, c_strlen(s));
 }
 
 bool utf8_valid_n(const char* s, isize nbytes) {
     utf8_decode_t d = {.state=0};
-    for (; nbytes-- != 0; ++s)
-        if ((utf8_decode(&d, (uint8_t)*s) == utf8_REJECT) | (*s == '\0'))
+    isize i = _utf8_valid_blocks(s, nbytes);
+    if (i < 0)
+        return false;
+    for (; i < nbytes; ++i) {
+        if (d.state == utf8_ACCEPT)
+            while ((nbytes - i >= 8) && _utf8_ascii8(s + i))
+                i += 8;
+        if (i == nbytes || (utf8_decode(&d, (uint8_t)s[i]) == utf8_REJECT) | (s[i] == '\0'))
             break;
+    }
     return d.state == utf8_ACCEPT;
 }
 
+isize utf8_count_n(const char* s, isize nbytes) {
+    isize n = 0, i = 0;
+  #if defined _utf8_SSE2
+    const __m128i zero = _mm_setzero_si128(), cont = _mm_set1_epi8(-65); /* > 0xBF signed */
+    bool nul = false;
+    while (!nul && nbytes - i >= 16) {
+        __m128i acc = zero; /* byte counters: flush before they overflow */
+        for (int k = 0; k < 255 && nbytes - i >= 16; ++k, i += 16) {
+            const __m128i in = _mm_loadu_si128((const __m128i*)(s + i));
+            if ((nul = _mm_movemask_epi8(_mm_cmpeq_epi8(in, zero)) != 0))
+                break;
+            acc = _mm_sub_epi8(acc, _mm_cmpgt_epi8(in, cont));
+        }
+        acc = _mm_sad_epu8(acc, zero);
+        n += _mm_cvtsi128_si32(acc) + _mm_extract_epi16(acc, 4);
+    }
+  #elif defined _utf8_NEON
+    const uint8x16_t mask = vdupq_n_u8(0xC0), cont = vdupq_n_u8(0x80);
+    bool nul = false;
+    while (!nul && nbytes - i >= 16) {
+        uint8x16_t acc = vdupq_n_u8(0);
+        for (int k = 0; k < 255 && nbytes - i >= 16; ++k, i += 16) {
+            const uint8x16_t in = vld1q_u8((const uint8_t*)s + i);
+            if ((nul = vminvq_u8(in) == 0))
+                break;
+            acc = vsubq_u8(acc, vmvnq_u8(vceqq_u8(vandq_u8(in, mask), cont)));
+        }
+        n += vaddlvq_u8(acc);
+    }
+  #endif
+    for (; i < nbytes && s[i] != '\0'; ++i)
+        n += (s[i] & 0xC0) != 0x80;
+    return n;
+}
+
 uint32_t utf8_casefold(uint32_t c) {
     for (int i=0; i < casefold_len; ++i) {
         const struct CaseMapping entry = casemappings[i];
@@ -139,20 +332,119 @@ int utf8_decode_codepoint(utf8_decode_t* d, const char* s, const char* end) { //
     return n > 2 ? n - 1 : 1;
 }
 
-int utf8_icompare(const csview s1, const csview s2) {
+/* ascii runs for case conversion and case-insensitive compare are processed 16 bytes at a
+ * time; only non-ascii runes go through the decoder and the case mapping tables. */
+#if defined _utf8_SSE2
+static inline __m128i _utf8_lower16(__m128i b) { /* bytes >= 0x80 are negative: kept */
+    const __m128i up = _mm_and_si128(_mm_cmpgt_epi8(b, _mm_set1_epi8('A' - 1)),
+                                     _mm_cmplt_epi8(b, _mm_set1_epi8('Z' + 1)));
+    return _mm_or_si128(b, _mm_and_si128(up, _mm_set1_epi8(0x20)));
+}
+#elif defined _utf8_NEON
+static inline uint8x16_t _utf8_lower16(uint8x16_t b) {
+    const uint8x16_t up = vcltq_u8(vsubq_u8(b, vdupq_n_u8('A')), vdupq_n_u8(26));
+    return vorrq_u8(b, vandq_u8(up, vdupq_n_u8(0x20)));
+}
+#endif
+
+isize _utf8_tocase_ascii(char* dst, const char* src, isize n, bool upper) {
+    isize i = 0;
+  #if defined _utf8_SSE2
+    const __m128i lo = _mm_set1_epi8(upper ? 'a' - 1 : 'A' - 1), hi = _mm_set1_epi8(upper ? 'z' + 1 : 'Z' + 1);
+    for (; n - i >= 16; i += 16) {
+        const __m128i b = _mm_loadu_si128((const __m128i*)(src + i));
+        if (_mm_movemask_epi8(b))
+            break;
+        const __m128i in = _mm_and_si128(_mm_cmpgt_epi8(b, lo), _mm_cmplt_epi8(b, hi));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(b, _mm_and_si128(in, _mm_set1_epi8(0x20))));
+    }
+  #elif defined _utf8_NEON
+    const uint8x16_t lo = vdupq_n_u8(upper ? 'a' : 'A');
+    for (; n - i >= 16; i += 16) {
+        const uint8x16_t b = vld1q_u8((const uint8_t*)src + i);
+        if (vmaxvq_u8(b) >= 0x80)
+            break;
+        const uint8x16_t in = vcltq_u8(vsubq_u8(b, lo), vdupq_n_u8(26));
+        vst1q_u8((uint8_t*)dst + i, veorq_u8(b, vandq_u8(in, vdupq_n_u8(0x20))));
+    }
+  #endif
+    const unsigned lo1 = upper ? 'a' : 'A';
+    for (; i < n && (uint8_t)src[i] < 0x80; ++i) {
+        const unsigned c = (uint8_t)src[i];
+        dst[i] = (char)(c - lo1 < 26 ? c ^ 0x20 : c);
+    }
+    return i;
+}
+
+/* number of leading bytes of s1 and s2 that are ascii, equal ignoring case, and not NUL
+ * in s2. n must be at least 16 */
+static isize _utf8_iprefix(const char* s1, const char* s2, isize n) {
+    isize i = 0;
+  #if defined _utf8_SSE2
+    for (; n - i >= 16; i += 16) {
+        const __m128i a = _mm_loadu_si128((const __m128i*)(s1 + i));
+        const __m128i b = _mm_loadu_si128((const __m128i*)(s2 + i));
+        const __m128i eq = _mm_cmpeq_epi8(_utf8_lower16(a), _utf8_lower16(b));
+        const unsigned m = ((unsigned)_mm_movemask_epi8(eq) ^ 0xFFFF)
+                         | (unsigned)_mm_movemask_epi8(_mm_or_si128(a, b))
+                         | (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(b, _mm_setzero_si128()));
+        if (m)
+            return i + c_trailing_zeros(m);
+    }
+  #elif defined _utf8_NEON
+    for (; n - i >= 16; i += 16) {
+        const uint8x16_t a = vld1q_u8((const uint8_t*)s1 + i);
+        const uint8x16_t b = vld1q_u8((const uint8_t*)s2 + i);
+        const uint8x16_t ok = vandq_u8(vandq_u8(vceqq_u8(_utf8_lower16(a), _utf8_lower16(b)),
+                                                vcltq_u8(vorrq_u8(a, b), vdupq_n_u8(0x80))),
+                                       vtstq_u8(b, b));
+        if (vminvq_u8(ok) == 0) {
+            // 4 bits per byte
+            uint64_t m = ~vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(ok), 4)), 0);
+            return i + (c_trailing_zeros(m) >> 2);
+        }
+    }
+  #else
+    (void)s1, (void)s2, (void)n;
+  #endif
+    return i;
+}
+
+static inline int _utf8_icompare(const char* s1, isize n1, const char* s2, isize n2, bool sized) {
     utf8_decode_t d1 = {.state=0}, d2 = {.state=0};
-    const char *e1 = s1.buf + s1.size, *e2 = s2.buf + s2.size;
+    const char *e1 = s1 + n1, *e2 = s2 + n2;
     isize j1 = 0, j2 = 0;
-    while ((j1 < s1.size) & (j2 < s2.size)) {
-        if (s2.buf[j2] == '\0') return s1.buf[j1];
+    while ((j1 < n1) & (j2 < n2)) {
+        if (sized && (n1 - j1 >= 16) & (n2 - j2 >= 16)) {
+            const isize k = _utf8_iprefix(s1 + j1, s2 + j2, n1 - j1 < n2 - j2 ? n1 - j1 : n2 - j2);
+            j1 += k, j2 += k;
+            if ((j1 == n1) | (j2 == n2))
+                break;
+        }
+        if (s2[j2] == '\0') return s1[j1];
 
-        j1 += utf8_decode_codepoint(&d1, s1.buf + j1, e1);
-        j2 += utf8_decode_codepoint(&d2, s2.buf + j2, e2);
+        const unsigned c1 = (uint8_t)s1[j1], c2 = (uint8_t)s2[j2];
+        if ((c1 | c2) < 0x80) {
+            const int c = (int)(c1 - 'A' < 26 ? c1 + 32 : c1) - (int)(c2 - 'A' < 26 ? c2 + 32 : c2);
+            if (c != 0) return c;
+            ++j1, ++j2;
+            continue;
+        }
+        j1 += utf8_decode_codepoint(&d1, s1 + j1, e1);
+        j2 += utf8_decode_codepoint(&d2, s2 + j2, e2);
 
         int32_t c = (int32_t)utf8_casefold(d1.codep) - (int32_t)utf8_casefold(d2.codep);
         if (c != 0) return (int)c;
     }
-    return (int)(s1.size - s2.size);
+    return (int)(n1 - n2);
+}
+
+int utf8_icompare(const csview s1, const csview s2) {
+    return _utf8_icompare(s1.buf, s1.size, s2.buf, s2.size, true);
+}
+
+int utf8_icmp(const char* s1, const char* s2) {
+    return _utf8_icompare(s1, INTPTR_MAX, s2, INTPTR_MAX, false);
 }
 
 #endif // STC_UTF8_PRV_C_INCLUDED
@@ -37,21 +37,12 @@ STC_INLINE int utf8_chr_size(const char *s) {
     /*return 0;*/
 }
 
-/* number of codepoints in the utf8 string s */
-STC_INLINE isize utf8_count(const char *s) {
-    isize size = 0;
-    while (*s)
-        size += (*++s & 0xC0) != 0x80;
-    return size;
-}
+/* number of codepoints in the first nbytes of s, or up to a NUL */
+extern isize utf8_count_n(const char *s, isize nbytes);
 
-STC_INLINE isize utf8_count_n(const char *s, isize nbytes) {
-    isize size = 0;
-    while ((nbytes-- != 0) & (*s != 0)) {
-        size += (*++s & 0xC0) != 0x80;
-    }
-    return size;
-}
+/* number of codepoints in the utf8 string s */
+STC_INLINE isize utf8_count(const char *s)
+    { return utf8_count_n(s, c_strlen(s)); }
 
 STC_INLINE const char* utf8_at(const char *s, isize u8pos) {
     while ((u8pos > 0) & (*s != 0))
@@ -120,8 +111,9 @@ STC_INLINE uint32_t utf8_peek(const char* s) {
 }
 
 /* case-insensitive utf8 string comparison */
-STC_INLINE int utf8_icmp(const char* s1, const char* s2) {
-    return utf8_icompare(c_sv(s1, INTPTR_MAX), c_sv(s2, INTPTR_MAX));
-}
+extern int utf8_icmp(const char* s1, const char* s2);
+
+/* convert the leading ascii run of src[0, n) to lower or upper case in dst. return its length */
+extern isize _utf8_tocase_ascii(char* dst, const char* src, isize n, bool upper);
 
 #endif // STC_UTF8_PRV_H_INCLUDED
@@ -71,6 +71,9 @@ int main(void) {
 #endif
 #define _i_sorted
 #include "priv/template.h"
+#ifdef i_snapshot
+  #include "csnap.h"
+#endif
 #ifndef i_declared
   _c_DEFTYPES(_c_aatree_types, Self, i_key, i_val, _i_MAP_ONLY, _i_SET_ONLY);
 #endif
@@ -108,6 +111,10 @@ STC_API _m_iter         _c_MEMB(_erase_at)(Self* self, _m_iter it);
 STC_API _m_iter         _c_MEMB(_erase_range)(Self* self, _m_iter it1, _m_iter it2);
 STC_API _m_iter         _c_MEMB(_begin)(const Self* self);
 STC_API void            _c_MEMB(_next)(_m_iter* it);
+#ifdef i_snapshot
+STC_API bool            _c_MEMB(_write_snapshot)(const Self* self, const char* path);
+STC_API bool            _c_MEMB(_view_snapshot)(Self* view, const csnap* snap);
+#endif
 
 STC_INLINE Self         _c_MEMB(_init)(void) { Self tree = {0}; return tree; }
 STC_INLINE bool         _c_MEMB(_is_empty)(const Self* cx) { return cx->size == 0; }
@@ -554,10 +561,13 @@ _c_MEMB(_clone_r_)(Self* self, _m_node* src, int32_t sn) {
 
 STC_DEF Self
 _c_MEMB(_clone)(Self tree) {
-    Self clone = _c_MEMB(_with_capacity)(tree.size);
+    Self clone = tree; // keeps aux and allocator context
+    clone.nodes = NULL, clone.root = clone.disp = clone.head = clone.size = clone.capacity = 0;
+    _c_MEMB(_reserve)(&clone, tree.size);
     tree.root = _c_MEMB(_clone_r_)(&clone, tree.nodes, tree.root);
     tree.nodes = clone.nodes;
     tree.disp = clone.disp;
+    tree.head = clone.head;
     tree.capacity = clone.capacity;
     return tree;
 }
@@ -593,7 +603,48 @@ _c_MEMB(_drop)(const Self* cself) {
     }
 }
 
+#ifdef i_snapshot
+// The nodes link to each other by index, so the node array is stored as is.
+STC_DEF bool
+_c_MEMB(_write_snapshot)(const Self* self, const char* path) {
+    csnap_header hdr = {.kind=csnap_SMAP, .flags=_i_SET_ONLY(4) _i_MAP_ONLY(0),
+                        .key_size=sizeof(_m_key), .value_size=sizeof(_m_value),
+                        .count=(uint64_t)self->size};
+    const void* section[csnap_SECTIONS] = {self->nodes};
+    hdr.param[0] = (uint64_t)self->root;
+    hdr.param[1] = (uint64_t)self->disp;
+    hdr.param[2] = (uint64_t)self->head;
+    hdr.bytes[0] = self->nodes ? (uint64_t)(self->head + 1)*sizeof(_m_node) : 0;
+    return csnap_write(path, hdr, section);
+}
+
+STC_DEF bool
+_c_MEMB(_view_snapshot)(Self* view, const csnap* snap) {
+    const csnap_header* h = csnap_check(snap, csnap_SMAP, _i_SET_ONLY(4) _i_MAP_ONLY(0),
+                                        c_sizeof(_m_key), c_sizeof(_m_value));
+    if (h == NULL)
+        return false;
+    const uint64_t head = h->param[2];
+    Self tree = {0};
+    if (h->bytes[0] == 0) { // never allocated
+        *view = tree;
+        return h->count == 0;
+    }
+    if (h->bytes[0] != (head + 1)*sizeof(_m_node) || head > INT32_MAX ||
+        h->count > head || h->param[0] > head || h->param[1] > head)
+        return false;
+    tree.nodes = (_m_node*)csnap_section(snap, 0);
+    tree.root = (int32_t)h->param[0];
+    tree.disp = (int32_t)h->param[1];
+    tree.head = tree.capacity = (int32_t)h->param[2];
+    tree.size = (int32_t)h->count;
+    *view = tree;
+    return true;
+}
+#endif // i_snapshot
+
 #endif // i_implement
+#undef i_snapshot
 #undef _i_is_set
 #undef _i_is_map
 #undef _i_sorted
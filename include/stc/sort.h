@@ -25,6 +25,7 @@ template params:
 #define i_key keytype   - [required] (or use i_type, see below)
 #define i_less(xp, yp)  - optional less function. default: *xp < *yp
 #define i_cmp(xp, yp)   - alternative 3-way comparison. c_default_cmp(xp, yp)
+#define i_radix_key(xp) - optional unsigned key with the same ordering: enables radix sort.
 #define i_type name     - optional, defines {name}_sort(), else {i_key}s_sort().
 #define i_type name,key - alternative one-liner to define both i_type and i_key.
 
@@ -60,14 +60,18 @@ STC_INLINE Self _c_MEMB(_move)(Self *self) {
     return m;
 }
 
+STC_INLINE bool _c_MEMB(_reserve)(Self* self, isize n);
+
 STC_INLINE Self _c_MEMB(_with_capacity)(isize cap) {
-    Self out = {_i_malloc(_m_value, cap), 0, cap};
+    Self out = {0};
+    _c_MEMB(_reserve)(&out, cap);
     return out;
 }
 
 STC_INLINE Self _c_MEMB(_with_size)(isize size, _m_value null) {
-    Self out = {_i_malloc(_m_value, size), size, size};
-    while (size) out.data[--size] = null;
+    Self out = {0};
+    if (_c_MEMB(_reserve)(&out, size))
+        while (out.size < size) out.data[out.size++] = null;
     return out;
 }
 #endif // i_capacity
@@ -186,13 +190,12 @@ STC_INLINE _m_value* _c_MEMB(_emplace)(Self* self, _m_raw raw)
 
 #if !defined i_no_clone
 STC_INLINE Self _c_MEMB(_clone)(Self s) {
-    Self tmp = {_i_malloc(_m_value, s.size), s.size, s.size};
-    if (tmp.data == NULL) tmp.capacity = 0;
-    else for (isize i = 0; i < s.size; ++s.data)
-        tmp.data[i++] = i_keyclone((*s.data));
-    s.data = tmp.data;
-    s.capacity = tmp.capacity;
-    return s;
+    Self tmp = s; // keeps aux and allocator context
+    tmp.data = NULL, tmp.size = tmp.capacity = 0;
+    if (_c_MEMB(_reserve)(&tmp, s.size))
+        for (; tmp.size < s.size; ++s.data)
+            tmp.data[tmp.size++] = i_keyclone((*s.data));
+    return tmp;
 }
 
 STC_INLINE void _c_MEMB(_copy)(Self *self, const Self other) {
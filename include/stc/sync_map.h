@@ -0,0 +1,279 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Concurrent hash map. Keys are spread over a power-of-two number of shards by the
+// high bits of their hash. Each shard is an hmap with its own lock, so threads only
+// contend when they access keys of the same shard.
+/*
+#include <stdio.h>
+
+#define i_type Hits, int, int
+#include "stc/sync_map.h"
+
+static void incr(int* count, bool inserted, void* ctx)
+    { (void)ctx; if (!inserted) *count += 1; }
+
+int main(void) {
+    Hits hits = Hits_init();
+    for (c_items(i, int, {3, 7, 3, 9, 3, 7})) // may be called from many threads
+        Hits_upsert(&hits, *i.ref, 1, incr, NULL);
+
+    for (c_range(s, Hits_shard_count(&hits))) {
+        Hits_shard* shard = Hits_lock_shard(&hits, s);
+        for (c_each(i, Hits_shard, *shard))
+            printf("%d: %d\n", i.ref->first, i.ref->second);
+        Hits_unlock_shard(&hits, s);
+    }
+    Hits_drop(&hits);
+}
+*/
+#ifndef STC_SYNC_MAP_H_INCLUDED
+#define STC_SYNC_MAP_H_INCLUDED
+#include "common.h"
+#ifdef STC_HAS_THREADS
+  #include <threads.h>
+  #define _sync_map_mutex mtx_t
+  #define _sync_map_init(m) mtx_init(m, mtx_plain)
+  #define _sync_map_destroy(m) mtx_destroy(m)
+  #define _sync_map_lock(m) mtx_lock(m)
+  #define _sync_map_unlock(m) mtx_unlock(m)
+#elif defined __unix__ || defined __APPLE__
+  #include <pthread.h>
+  #define _sync_map_mutex pthread_mutex_t
+  #define _sync_map_init(m) pthread_mutex_init(m, NULL)
+  #define _sync_map_destroy(m) pthread_mutex_destroy(m)
+  #define _sync_map_lock(m) pthread_mutex_lock(m)
+  #define _sync_map_unlock(m) pthread_mutex_unlock(m)
+#else
+  #error "sync_map requires C11 <threads.h> or POSIX threads"
+#endif
+#endif // STC_SYNC_MAP_H_INCLUDED
+
+#ifndef _i_prefix
+  #define _i_prefix sync_map_
+#endif
+#if defined i_type && c_NUMARGS(i_type) > 1
+  #define _i_sync c_GETARG(1, i_type)
+#elif defined i_type
+  #define _i_sync i_type
+#else
+  #define _i_sync c_JOIN(_i_prefix, i_tag)
+#endif
+#ifndef i_shards
+  #define i_shards 64
+#endif
+#if defined i_allocator_ctx
+  #error "sync_map does not support i_allocator_ctx"
+#endif
+
+// Instantiate the shard type Self_shard as an hmap with the same template parameters.
+#define Self c_JOIN(_i_sync, _shard)
+#define _i_is_shard
+#include "hmap.h"
+#undef _i_is_shard
+#undef Self
+#define Self _i_sync
+#define _i_shard c_JOIN(Self, _shard)
+#define _i_shard_fn(name) c_JOIN(_i_shard, name)
+
+typedef _i_shard_fn(_key) _m_key;
+typedef _i_shard_fn(_mapped) _m_mapped;
+typedef _i_shard_fn(_keyraw) _m_keyraw;
+typedef _i_shard_fn(_rmapped) _m_rmapped;
+typedef _i_shard_fn(_value) _m_value;
+
+typedef struct {
+    _i_shard map;
+    _sync_map_mutex mtx;
+    char _pad[64]; // shards used by different threads should not share cache lines
+} _c_MEMB(_segment);
+
+typedef struct Self {
+    _c_MEMB(_segment)* seg;
+    isize nshards;
+    int shift;
+} Self;
+
+// Not thread-safe: construct the map before sharing it. cap is the expected number of
+// entries in total. Returns a map without shards if allocation fails.
+STC_INLINE Self _c_MEMB(_with_capacity)(const isize cap) {
+    Self m = {NULL, 0, 64};
+    isize n = c_next_pow2(i_shards < 2 ? 2 : i_shards);
+    m.seg = _i_malloc(_c_MEMB(_segment), n);
+    if (m.seg == NULL)
+        return m;
+    for (m.nshards = n; n > 1; n >>= 1)
+        --m.shift;
+    for (c_range(i, m.nshards)) {
+        m.seg[i].map = _i_shard_fn(_with_capacity)(cap/m.nshards);
+        _sync_map_init(&m.seg[i].mtx);
+    }
+    return m;
+}
+
+STC_INLINE Self _c_MEMB(_init)(void)
+    { return _c_MEMB(_with_capacity)(0); }
+
+// Not thread-safe: drop the map after the threads using it are joined.
+STC_INLINE void _c_MEMB(_drop)(const Self* self) {
+    for (c_range(i, self->nshards)) {
+        _i_shard_fn(_drop)(&self->seg[i].map);
+        _sync_map_destroy(&self->seg[i].mtx);
+    }
+    i_free(self->seg, self->nshards*c_sizeof *self->seg);
+}
+
+STC_INLINE isize _c_MEMB(_shard_count)(const Self* self)
+    { return self->nshards; }
+
+// The shard of a key is picked by the high bits of its (Fibonacci-mixed) hash,
+// so it does not correlate with the bucket index within the shard.
+STC_INLINE _c_MEMB(_segment)* _c_MEMB(_segment_)(const Self* self, const size_t hash)
+    { return &self->seg[((uint64_t)hash*0x9e3779b97f4a7c15U) >> self->shift]; }
+
+// Locks shard i (0 <= i < shard_count) and returns its hmap. Threads accessing keys of
+// the shard block until unlock_shard(). Use it to iterate over or bulk-update a shard.
+STC_INLINE _i_shard* _c_MEMB(_lock_shard)(Self* self, const isize i) {
+    c_assert(0 <= i && i < self->nshards);
+    _sync_map_lock(&self->seg[i].mtx);
+    return &self->seg[i].map;
+}
+
+STC_INLINE void _c_MEMB(_unlock_shard)(Self* self, const isize i)
+    { _sync_map_unlock(&self->seg[i].mtx); }
+
+// A snapshot only, when other threads are updating the map.
+STC_INLINE isize _c_MEMB(_size)(const Self* self) {
+    isize n = 0;
+    for (c_range(i, self->nshards)) {
+        n += _i_shard_fn(_size)(_c_MEMB(_lock_shard)((Self*)self, i));
+        _c_MEMB(_unlock_shard)((Self*)self, i);
+    }
+    return n;
+}
+
+STC_INLINE bool _c_MEMB(_is_empty)(const Self* self)
+    { return _c_MEMB(_size)(self) == 0; }
+
+STC_INLINE void _c_MEMB(_clear)(Self* self) {
+    for (c_range(i, self->nshards)) {
+        _i_shard_fn(_clear)(_c_MEMB(_lock_shard)(self, i));
+        _c_MEMB(_unlock_shard)(self, i);
+    }
+}
+
+STC_INLINE bool _c_MEMB(_contains)(const Self* self, _m_keyraw rkey) {
+    const size_t hash = _i_shard_fn(_key_hash)(rkey);
+    _c_MEMB(_segment)* s = _c_MEMB(_segment_)(self, hash);
+    _sync_map_lock(&s->mtx);
+    const bool found = _i_shard_fn(_get_hashed)(&s->map, rkey, hash) != NULL;
+    _sync_map_unlock(&s->mtx);
+    return found;
+}
+
+#if !defined i_no_clone
+// Stores a clone of the mapped value of rkey in *out, unless out is NULL.
+// Returns false if rkey is not in the map.
+STC_INLINE bool _c_MEMB(_find)(const Self* self, _m_keyraw rkey, _m_mapped* out) {
+    const size_t hash = _i_shard_fn(_key_hash)(rkey);
+    _c_MEMB(_segment)* s = _c_MEMB(_segment_)(self, hash);
+    _sync_map_lock(&s->mtx);
+    const _m_value* ref = _i_shard_fn(_get_hashed)(&s->map, rkey, hash);
+    if (ref != NULL && out != NULL)
+        *out = i_valclone(ref->second);
+    _sync_map_unlock(&s->mtx);
+    return ref != NULL;
+}
+#endif
+
+// Returns true if key was inserted. Otherwise key and mapped are dropped.
+STC_INLINE bool _c_MEMB(_insert)(Self* self, _m_key key, _m_mapped mapped) {
+    const size_t hash = _i_shard_fn(_key_hash)(i_keytoraw((&key)));
+    _c_MEMB(_segment)* s = _c_MEMB(_segment_)(self, hash);
+    _sync_map_lock(&s->mtx);
+    const bool inserted = _i_shard_fn(_insert_hashed)(&s->map, key, mapped, hash).inserted;
+    _sync_map_unlock(&s->mtx);
+    return inserted;
+}
+
+// Returns true if key was inserted. Otherwise the existing mapped value is replaced,
+// or key and mapped are dropped if the map could not grow.
+STC_INLINE bool _c_MEMB(_insert_or_assign)(Self* self, _m_key key, _m_mapped mapped) {
+    const size_t hash = _i_shard_fn(_key_hash)(i_keytoraw((&key)));
+    _c_MEMB(_segment)* s = _c_MEMB(_segment_)(self, hash);
+    _sync_map_lock(&s->mtx);
+    _i_shard_fn(_result) res = _i_shard_fn(_insert_entry_hashed_)(&s->map, i_keytoraw((&key)), hash);
+    _m_mapped* mp = res.ref ? &res.ref->second : &mapped;
+    if (res.inserted)
+        res.ref->first = key;
+    else
+        { i_keydrop((&key)); i_valdrop(mp); }
+    *mp = mapped;
+    _sync_map_unlock(&s->mtx);
+    return res.inserted;
+}
+
+// Adds rkey with a value made from rmapped if rkey is not in the map. Then, unless update
+// is NULL, calls update(&mapped, inserted, ctx) while the shard is locked, e.g. to bump a
+// counter. update must not access the map. Returns true if rkey was inserted.
+// With i_no_emplace, rkey and rmapped are moved into the map, or dropped like in insert().
+STC_INLINE bool _c_MEMB(_upsert)(Self* self, _m_keyraw rkey, _m_rmapped rmapped,
+                                 void (*update)(_m_mapped* mapped, bool inserted, void* ctx),
+                                 void* ctx) {
+    const size_t hash = _i_shard_fn(_key_hash)(rkey);
+    _c_MEMB(_segment)* s = _c_MEMB(_segment_)(self, hash);
+    _sync_map_lock(&s->mtx);
+    #if defined i_no_emplace
+    _i_shard_fn(_result) res = _i_shard_fn(_insert_hashed)(&s->map, rkey, rmapped, hash);
+    #else
+    _i_shard_fn(_result) res = _i_shard_fn(_emplace_hashed)(&s->map, rkey, rmapped, hash);
+    #endif
+    if (update != NULL && res.ref != NULL) // ref is NULL if the map could not grow
+        update(&res.ref->second, res.inserted, ctx);
+    _sync_map_unlock(&s->mtx);
+    return res.inserted;
+}
+
+#if !defined i_no_emplace
+// Returns true if rkey was inserted. The key and value are only constructed then.
+STC_INLINE bool _c_MEMB(_emplace)(Self* self, _m_keyraw rkey, _m_rmapped rmapped)
+    { return _c_MEMB(_upsert)(self, rkey, rmapped, NULL, NULL); }
+#endif
+
+STC_INLINE int _c_MEMB(_erase)(Self* self, _m_keyraw rkey) {
+    const size_t hash = _i_shard_fn(_key_hash)(rkey);
+    _c_MEMB(_segment)* s = _c_MEMB(_segment_)(self, hash);
+    _sync_map_lock(&s->mtx);
+    _m_value* ref = (_m_value*)_i_shard_fn(_get_hashed)(&s->map, rkey, hash);
+    if (ref != NULL)
+        _i_shard_fn(_erase_entry)(&s->map, ref);
+    _sync_map_unlock(&s->mtx);
+    return ref != NULL;
+}
+
+#undef i_shards
+#undef _i_shard_fn
+#undef _i_shard
+#include "priv/linkage2.h"
+#include "priv/template2.h"
+#undef _i_sync
@@ -21,10 +21,39 @@
  * SOFTWARE.
  */
 
+#undef _i_alloc_struct
+#ifdef i_allocator_ctx
+  #define _i_alloc_struct i_allocator* alloc;
+#else
+  #define _i_alloc_struct
+#endif
 #ifdef i_aux
-  #define _i_aux_struct struct c_JOIN(Self, _aux) i_aux aux;
+  #define _i_aux_struct struct c_JOIN(Self, _aux) i_aux aux; _i_alloc_struct
 #else
-  #define _i_aux_struct
+  #define _i_aux_struct _i_alloc_struct
+#endif
+#undef _i_rehash_struct
+#undef _i_rehash_iter_struct
+#ifdef i_incremental_rehash
+  #define _i_rehash_struct(SELF) \
+    struct { SELF##_value* table; struct hmap_meta* meta; ptrdiff_t bucket_count, pos; } _old;
+  #define _i_rehash_iter_struct(SELF) \
+    struct { SELF##_value* table; struct hmap_meta* meta; ptrdiff_t bucket_count; } _old;
+#else
+  #define _i_rehash_struct(SELF)
+  #define _i_rehash_iter_struct(SELF)
+#endif
+#undef _i_bucket_struct
+#ifdef i_store_hash
+  #define _i_bucket_struct uint32_t* hashes;
+#else
+  #define _i_bucket_struct
+#endif
+#undef _i_stats_struct
+#ifdef i_stats
+  #define _i_stats_struct struct { ptrdiff_t rehashes, peak_dist; } _stats;
+#else
+  #define _i_stats_struct
 #endif
 
 #ifndef STC_TYPES_H_INCLUDED
@@ -45,6 +74,9 @@
 #define declare_pqueue(C, VAL) _c_pqueue_types(C, VAL)
 #define declare_queue(C, VAL) _c_deque_types(C, VAL)
 #define declare_vec(C, VAL) _c_vec_types(C, VAL)
+#define declare_mpmc_queue(C, VAL) _c_mpmc_queue_types(C, VAL)
+#define declare_bmap(C, KEY, VAL) _c_btree_types(C, KEY, VAL, c_true, c_false)
+#define declare_bset(C, KEY) _c_btree_types(C, KEY, KEY, c_false, c_true)
 
 #define declare_hmap(...) declare_hashmap(__VA_ARGS__) // [deprecated]
 #define declare_hset(...) declare_hashset(__VA_ARGS__) // [deprecated]
@@ -163,12 +195,16 @@ typedef union {
     typedef struct { \
         SELF##_value *ref, *_end; \
         struct hmap_meta *_mref; \
+        _i_rehash_iter_struct(SELF) \
     } SELF##_iter; \
 \
     typedef struct SELF { \
         SELF##_value* table; \
         struct hmap_meta* meta; \
         ptrdiff_t size, bucket_count; \
+        _i_rehash_struct(SELF) \
+        _i_bucket_struct \
+        _i_stats_struct \
         _i_aux_struct \
     } SELF
 
@@ -199,6 +235,32 @@ typedef union {
         _i_aux_struct \
     } SELF
 
+#define _c_btree_types(SELF, KEY, VAL, MAP_ONLY, SET_ONLY) \
+    typedef KEY SELF##_key; \
+    typedef VAL SELF##_mapped; \
+    typedef struct SELF##_leaf SELF##_leaf; \
+\
+    typedef SET_ONLY( SELF##_key ) \
+            MAP_ONLY( struct SELF##_value ) \
+    SELF##_value, SELF##_entry; \
+\
+    typedef struct { \
+        SELF##_value *ref; \
+        bool inserted; \
+    } SELF##_result; \
+\
+    typedef struct { \
+        SELF##_value *ref, *_end; \
+        SELF##_leaf *_leaf; \
+    } SELF##_iter; \
+\
+    typedef struct SELF { \
+        void *root; \
+        ptrdiff_t size; \
+        int height; \
+        _i_aux_struct \
+    } SELF
+
 #define _c_stack_fixed(SELF, VAL, CAP) \
     typedef VAL SELF##_value; \
     typedef struct { SELF##_value *ref, *end; } SELF##_iter; \
@@ -209,4 +271,19 @@ typedef union {
     typedef struct { SELF##_value *ref, *end; } SELF##_iter; \
     typedef struct SELF { SELF##_value *data; ptrdiff_t size, capacity; _i_aux_struct } SELF
 
+// head and tail are kept on separate cache lines: catomic_isize is defined in priv/atomic_prv.h
+#define _c_mpmc_queue_types(SELF, VAL) \
+    typedef VAL SELF##_value; \
+    typedef struct { catomic_isize seq; SELF##_value value; } SELF##_slot; \
+\
+    typedef struct SELF { \
+        SELF##_slot *slots; \
+        ptrdiff_t capmask; \
+        char _pad0[64]; \
+        catomic_isize head; \
+        char _pad1[64 - sizeof(ptrdiff_t)]; \
+        catomic_isize tail; \
+        char _pad2[64 - sizeof(ptrdiff_t)]; \
+    } SELF
+
 #endif // STC_TYPES_H_INCLUDED
@@ -73,6 +73,9 @@ int main(void) {
   #define _i_prefix vec_
 #endif
 #include "priv/template.h"
+#ifdef i_snapshot
+  #include "csnap.h"
+#endif
 
 #ifndef i_declared
    _c_DEFTYPES(_c_vec_types, Self, i_key);
@@ -87,6 +90,10 @@ STC_API _m_iter         _c_MEMB(_insert_uninit)(Self* self, isize idx, isize n);
 #if defined _i_has_eq
 STC_API _m_iter         _c_MEMB(_find_in)(const Self* self, _m_iter it1, _m_iter it2, _m_raw raw);
 #endif // _i_has_eq
+#ifdef i_snapshot
+STC_API bool            _c_MEMB(_write_snapshot)(const Self* self, const char* path);
+STC_API bool            _c_MEMB(_view_snapshot)(Self* view, const csnap* snap);
+#endif
 STC_INLINE Self         _c_MEMB(_init)(void) { return c_literal(Self){0}; }
 STC_INLINE void         _c_MEMB(_value_drop)(_m_value* val) { i_keydrop(val); }
 
@@ -372,6 +379,30 @@ _c_MEMB(_find_in)(const Self* self, _m_iter i1, _m_iter i2, _m_raw raw) {
     return i2;
 }
 #endif //  _i_has_eq
+
+#ifdef i_snapshot
+STC_DEF bool
+_c_MEMB(_write_snapshot)(const Self* self, const char* path) {
+    csnap_header hdr = {.kind=csnap_VEC, .flags=0, .key_size=sizeof(_m_value),
+                        .value_size=sizeof(_m_value), .count=(uint64_t)self->size};
+    const void* section[csnap_SECTIONS] = {self->data};
+    hdr.bytes[0] = (uint64_t)self->size*sizeof(_m_value);
+    return csnap_write(path, hdr, section);
+}
+
+STC_DEF bool
+_c_MEMB(_view_snapshot)(Self* view, const csnap* snap) {
+    const csnap_header* h = csnap_check(snap, csnap_VEC, 0, c_sizeof(_m_value), c_sizeof(_m_value));
+    if (h == NULL || h->bytes[0] != h->count*sizeof(_m_value))
+        return false;
+    Self vec = {0};
+    vec.data = (_m_value*)csnap_section(snap, 0);
+    vec.size = vec.capacity = (isize)h->count;
+    *view = vec;
+    return true;
+}
+#endif // i_snapshot
 #endif // i_implement
+#undef i_snapshot
 #include "priv/linkage2.h"
 #include "priv/template2.h"
@@ -5,6 +5,9 @@ python singleheader.py $d/include/stc/algorithm.h $d/../stcsingle/stc/algorithm.
 python singleheader.py $d/include/stc/coroutine.h $d/../stcsingle/stc/coroutine.h
 python singleheader.py $d/include/stc/sort.h $d/../stcsingle/stc/sort.h
 python singleheader.py $d/include/stc/random.h $d/../stcsingle/stc/random.h
+python singleheader.py $d/include/stc/carena.h $d/../stcsingle/stc/carena.h
+python singleheader.py $d/include/stc/cpool.h  $d/../stcsingle/stc/cpool.h
+python singleheader.py $d/include/stc/catom.h  $d/../stcsingle/stc/catom.h
 python singleheader.py $d/include/stc/arc.h    $d/../stcsingle/stc/arc.h
 python singleheader.py $d/include/stc/cbits.h   $d/../stcsingle/stc/cbits.h
 python singleheader.py $d/include/stc/box.h    $d/../stcsingle/stc/box.h
@@ -16,6 +19,7 @@ python singleheader.py $d/include/stc/coption.h $d/../stcsingle/stc/coption.h
 python singleheader.py $d/include/stc/pqueue.h   $d/../stcsingle/stc/pqueue.h
 python singleheader.py $d/include/stc/queue.h  $d/../stcsingle/stc/queue.h
 python singleheader.py $d/include/stc/cregex.h  $d/../stcsingle/stc/cregex.h
+python singleheader.py $d/include/stc/crope.h   $d/../stcsingle/stc/crope.h
 python singleheader.py $d/include/stc/hset.h    $d/../stcsingle/stc/hset.h
 python singleheader.py $d/include/stc/smap.h   $d/../stcsingle/stc/smap.h
 python singleheader.py $d/include/stc/cspan.h   $d/../stcsingle/stc/cspan.h
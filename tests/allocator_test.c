@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include "ctest.h"
+#include "stc/cstr.h"
+#include "stc/carena.h"
+#include "stc/cpool.h"
+
+#define i_type AVec, int
+#define i_allocator carena
+#define i_allocator_ctx
+#include "stc/vec.h"
+
+#define i_type AMap, int, cstr
+#define i_valpro cstr
+#define i_allocator carena
+#define i_allocator_ctx
+#include "stc/hashmap.h"
+
+#define i_type PList, int, (c_use_cmp)
+#define i_allocator cpool
+#define i_allocator_ctx
+#include "stc/list.h"
+
+#define i_type PSet, int
+#define i_allocator cpool
+#define i_allocator_ctx
+#include "stc/sortedset.h"
+
+
+TEST(allocator, arena)
+{
+    carena arena = carena_with_capacity(1 << 12);
+    for (c_range(request, 3)) {
+        AVec vec = {.alloc=&arena};
+        AMap map = {.alloc=&arena};
+        for (c_range32(i, 10000)) {
+            AVec_push(&vec, i);
+            AMap_emplace(&map, i, "value");
+        }
+        AMap clone = AMap_clone(map);
+        EXPECT_TRUE(clone.alloc == &arena);
+        EXPECT_EQ(10000, AVec_size(&vec));
+        EXPECT_EQ(9999, *AVec_back(&vec));
+        EXPECT_EQ(10000, AMap_size(&clone));
+        EXPECT_STREQ("value", cstr_str(AMap_at(&clone, 1234)));
+
+        c_drop(AMap, &map, &clone); // drops the cstr values
+        carena_reset(&arena);       // releases vec and the maps' tables
+        EXPECT_TRUE(arena.blocks != NULL && arena.blocks->next == NULL);
+    }
+    carena_drop(&arena);
+    EXPECT_TRUE(arena.blocks == NULL);
+}
+
+TEST(allocator, pool)
+{
+    cpool pool = cpool_init();
+    PList list = {.alloc=&pool};
+    PSet set = {.alloc=&pool};
+    for (c_range32(i, 5000)) {
+        PList_push_front(&list, i);
+        PSet_insert(&set, i);
+    }
+    PList copy = PList_clone(list);
+    EXPECT_TRUE(copy.alloc == &pool);
+    PList_sort(&copy);
+    EXPECT_EQ(0, *PList_front(&copy));
+    EXPECT_EQ(4999, *PList_back(&copy));
+    EXPECT_EQ(5000, PSet_size(&set));
+
+    // recycled nodes: no new slabs are allocated when list is refilled
+    struct cpool_slab* slabs = pool.slabs;
+    PList_clear(&list);
+    for (c_range32(i, 5000))
+        PList_push_back(&list, i);
+    EXPECT_TRUE(pool.slabs == slabs);
+    EXPECT_TRUE(PList_eq(&list, &copy));
+
+    c_drop(PList, &list, &copy);
+    PSet_drop(&set);
+    cpool_drop(&pool);
+}
@@ -0,0 +1,170 @@
+#include "ctest.h"
+#include "stc/cstr.h"
+#include "stc/random.h"
+
+#define i_type BMap, int, int, (c_use_eq)
+#include "stc/bmap.h"
+
+#define i_type SMap, int, int
+#include "stc/sortedmap.h"
+
+#define i_type BSet
+#define i_keypro cstr
+#include "stc/bset.h"
+
+static int alloc_budget = -1; // number of allocations that succeed, or -1
+static void* lim_malloc(isize sz)
+    { return alloc_budget == 0 ? NULL : (alloc_budget -= alloc_budget > 0, c_malloc(sz)); }
+#define lim_calloc(n, sz) c_calloc(n, sz)
+#define lim_realloc(p, old_sz, sz) c_realloc(p, old_sz, sz)
+#define lim_free(p, sz) c_free(p, sz)
+
+#define i_type LMap, int, int, (c_use_eq)
+#define i_allocator lim
+#include "stc/bmap.h"
+
+TEST(bmap, random_ops)
+{
+    BMap m = {0};
+    SMap ref = {0};
+    crand64_seed(1);
+    for (c_range(i, 200000)) {
+        int key = (int)(crand64_uint() % 20000);
+        if (i % 3 == 2) {
+            EXPECT_EQ(SMap_erase(&ref, key), BMap_erase(&m, key));
+        } else {
+            BMap_insert_or_assign(&m, key, (int)i);
+            SMap_insert_or_assign(&ref, key, (int)i);
+        }
+        if (i == 100000) { // shrink to a small tree, then grow again
+            for (c_range32(k, 20000))
+                if (k % 50) BMap_erase(&m, k), SMap_erase(&ref, k);
+        }
+    }
+    ASSERT_EQ(SMap_size(&ref), BMap_size(&m));
+    BMap_iter it = BMap_begin(&m);
+    for (c_each(r, SMap, ref)) {
+        ASSERT_TRUE(it.ref != NULL);
+        EXPECT_EQ(r.ref->first, it.ref->first);
+        EXPECT_EQ(r.ref->second, it.ref->second);
+        BMap_next(&it);
+    }
+    EXPECT_TRUE(it.ref == NULL);
+    for (c_range32(k, -1, 20001)) {
+        SMap_iter r = SMap_lower_bound(&ref, k);
+        BMap_iter b = BMap_lower_bound(&m, k);
+        ASSERT_EQ(r.ref == NULL, b.ref == NULL);
+        if (r.ref) EXPECT_EQ(r.ref->first, b.ref->first);
+    }
+
+    BMap copy = BMap_clone(m);
+    EXPECT_TRUE(BMap_eq(&copy, &m));
+    BMap_iter first = BMap_advance(BMap_begin(&copy), 100);
+    BMap_iter last = BMap_advance(first, 1000);
+    const int k1 = first.ref->first, k2 = last.ref->first;
+    it = BMap_erase_range(&copy, first, last);
+    EXPECT_EQ(k2, it.ref->first);
+    EXPECT_EQ(BMap_size(&m) - 1000, BMap_size(&copy));
+    EXPECT_FALSE(BMap_contains(&copy, k1));
+    EXPECT_TRUE(BMap_advance(BMap_begin(&copy), 99).ref->first < k1);
+
+    BMap_erase_range(&copy, BMap_begin(&copy), BMap_end(&copy));
+    EXPECT_TRUE(BMap_is_empty(&copy));
+    EXPECT_TRUE(BMap_front(&copy) == NULL);
+    c_drop(BMap, &m, &copy);
+    SMap_drop(&ref);
+}
+
+TEST(bmap, string_set)
+{
+    BSet s = {0};
+    char buf[40];
+    for (c_range32(i, 5000)) {
+        snprintf(buf, sizeof buf, "%s-%05d", i % 2 ? "long string with heap buffer" : "sso", i);
+        BSet_emplace(&s, buf);
+    }
+    for (c_range32(i, 0, 5000, 3)) {
+        snprintf(buf, sizeof buf, "%s-%05d", i % 2 ? "long string with heap buffer" : "sso", i);
+        EXPECT_EQ(1, BSet_erase(&s, buf));
+    }
+    EXPECT_EQ(5000 - 1667, BSet_size(&s));
+    EXPECT_TRUE(BSet_contains(&s, "sso-00002"));
+    EXPECT_FALSE(BSet_contains(&s, "sso-00006"));
+    EXPECT_STREQ("long string with heap buffer-00001", cstr_str(BSet_front(&s)));
+    EXPECT_STREQ("sso-04996", cstr_str(BSet_back(&s)));
+
+    const cstr* prev = NULL;
+    isize n = 0;
+    for (c_each(i, BSet, s)) {
+        if (prev) EXPECT_TRUE(cstr_cmp(prev, i.ref) < 0);
+        prev = i.ref, ++n;
+    }
+    EXPECT_EQ(BSet_size(&s), n);
+    BSet_drop(&s);
+}
+
+TEST(bmap, erase_range)
+{
+    BMap m = {0};
+    SMap ref = {0};
+    crand64_seed(2);
+    for (c_range(round, 200)) {
+        for (c_range(i, 2000)) {
+            int key = (int)(crand64_uint() % 100000);
+            BMap_insert(&m, key, key);
+            SMap_insert(&ref, key, key);
+        }
+        const int k1 = (int)(crand64_uint() % 100000);
+        const int k2 = round % 10 == 9 ? -1 : k1 + (int)(crand64_uint() % 20000);
+        BMap_iter b2 = k2 < 0 ? BMap_end(&m) : BMap_lower_bound(&m, k2);
+        SMap_iter r2 = k2 < 0 ? SMap_end(&ref) : SMap_lower_bound(&ref, k2);
+        BMap_iter b = BMap_erase_range(&m, BMap_lower_bound(&m, k1), b2);
+        SMap_iter r = SMap_erase_range(&ref, SMap_lower_bound(&ref, k1), r2);
+        ASSERT_EQ(r.ref == NULL, b.ref == NULL);
+        if (r.ref) EXPECT_EQ(r.ref->first, b.ref->first);
+        ASSERT_EQ(SMap_size(&ref), BMap_size(&m));
+    }
+    BMap_iter it = BMap_begin(&m);
+    for (c_each(r, SMap, ref)) {
+        ASSERT_TRUE(it.ref != NULL);
+        EXPECT_EQ(r.ref->first, it.ref->first);
+        BMap_next(&it);
+    }
+    EXPECT_TRUE(it.ref == NULL);
+    c_drop(BMap, &m);
+    SMap_drop(&ref);
+
+    BSet s = {0};
+    char buf[40];
+    for (c_range32(i, 3000)) {
+        snprintf(buf, sizeof buf, "%s-%05d", i % 2 ? "long string with heap buffer" : "sso", i);
+        BSet_emplace(&s, buf);
+    }
+    BSet_iter last = BSet_find(&s, "sso-02000");
+    last = BSet_erase_range(&s, BSet_find(&s, "sso-00100"), last);
+    EXPECT_STREQ("sso-02000", cstr_str(last.ref));
+    EXPECT_EQ(3000 - 950, BSet_size(&s));
+    EXPECT_TRUE(BSet_contains(&s, "sso-00098"));
+    EXPECT_FALSE(BSet_contains(&s, "sso-01000"));
+    BSet_drop(&s);
+}
+
+TEST(bmap, clone_out_of_memory)
+{
+    LMap m = {0};
+    for (c_range32(i, 20000))
+        LMap_insert(&m, i, i);
+    for (int budget = 0; ; budget += 37) {
+        alloc_budget = budget;
+        LMap copy = LMap_clone(m);
+        alloc_budget = -1;
+        if (copy.root != NULL) {
+            EXPECT_TRUE(LMap_eq(&copy, &m));
+            LMap_drop(&copy);
+            break;
+        }
+        EXPECT_TRUE(LMap_is_empty(&copy));
+        EXPECT_TRUE(LMap_begin(&copy).ref == NULL);
+    }
+    LMap_drop(&m);
+}
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include "ctest.h"
+#include "stc/catom.h"
+#include "stc/csview.h"
+
+#define i_type AtomCount, catom, int, c_keyclass
+#include "stc/hmap.h"
+
+#define i_type AtomSet, catom, c_keyclass
+#include "stc/sset.h"
+
+TEST(catom, intern) {
+    catompool pool = catompool_init();
+    catom a = catompool_intern(&pool, "example.com");
+    catom b = catompool_intern_sv(&pool, c_sv("example.com:8080", 11));
+    catom c = catompool_intern(&pool, "stc.dev");
+    EXPECT_TRUE(catom_eq(&a, &b));
+    EXPECT_FALSE(catom_eq(&a, &c));
+    EXPECT_STREQ("example.com", catom_str(a));
+    EXPECT_EQ(11, catom_size(a));
+    EXPECT_EQ(csview_hash(&c_sv("stc.dev")), catom_hash(&c));
+    EXPECT_EQ(2, catompool_size(&pool));
+    EXPECT_TRUE(catom_is_null(catompool_find(&pool, "example")));
+    EXPECT_TRUE(catompool_find(&pool, "stc.dev").node == c.node);
+
+    // many atoms, some larger than an allocation block
+    char buf[64];
+    for (c_range(i, 20000)) {
+        snprintf(buf, sizeof buf, "host-%d.example.com", (int)(i % 10000));
+        catom x = catompool_intern(&pool, buf);
+        EXPECT_STREQ(buf, catom_str(x));
+    }
+    EXPECT_EQ(10002, catompool_size(&pool));
+    char* big = (char*)calloc(catom_BLOCK_SIZE, 1);
+    memset(big, 'x', catom_BLOCK_SIZE - 1);
+    catom x = catompool_intern(&pool, big);
+    EXPECT_TRUE(catompool_intern(&pool, big).node == x.node);
+    EXPECT_EQ(catom_BLOCK_SIZE - 1, catom_size(x));
+    free(big);
+    EXPECT_STREQ("example.com", catom_str(catompool_find(&pool, "example.com")));
+
+    AtomCount count = {0};
+    AtomSet set = {0};
+    const char* hosts[] = {"b.dev", "a.dev", "b.dev", "c.dev", "a.dev", "b.dev"};
+    for (c_range(i, c_arraylen(hosts))) {
+        catom h = catompool_intern(&pool, hosts[i]);
+        AtomCount_insert(&count, h, 0).ref->second += 1;
+        AtomSet_insert(&set, h);
+    }
+    EXPECT_EQ(3, *AtomCount_at(&count, catompool_find(&pool, "b.dev")));
+    EXPECT_FALSE(AtomCount_contains(&count, catompool_find(&pool, "d.dev")));
+    const char* sorted = "a.dev";
+    for (c_each(i, AtomSet, set)) {
+        EXPECT_STREQ(sorted, catom_str(*i.ref));
+        sorted = *sorted == 'a' ? "b.dev" : "c.dev";
+    }
+    AtomSet_drop(&set);
+    AtomCount_drop(&count);
+    catompool_drop(&pool);
+}
+
+TEST(catom, refcounted) {
+    catompool pool = catompool_init_refcounted();
+    AtomCount count = {0};
+    catom a = catompool_intern(&pool, "a.dev");
+    for (c_range(i, 100)) {
+        char buf[32];
+        snprintf(buf, sizeof buf, "host-%d", (int)(i % 10));
+        AtomCount_insert(&count, catompool_intern(&pool, buf), 0).ref->second += 1;
+    }
+    EXPECT_EQ(11, catompool_size(&pool));
+    EXPECT_EQ(10, *AtomCount_at(&count, catompool_find(&pool, "host-3")));
+
+    AtomCount copy = AtomCount_clone(count);
+    AtomCount_erase(&count, catompool_find(&pool, "host-3"));
+    EXPECT_EQ(11, catompool_size(&pool)); // still referenced by copy
+    AtomCount_drop(&count);
+    EXPECT_EQ(11, catompool_size(&pool));
+    AtomCount_drop(&copy);
+    EXPECT_EQ(1, catompool_size(&pool));
+
+    catom b = catom_clone(a);
+    catom_drop(&a);
+    EXPECT_STREQ("a.dev", catom_str(catompool_find(&pool, "a.dev")));
+    catom_drop(&b);
+    EXPECT_EQ(0, catompool_size(&pool));
+    EXPECT_TRUE(catom_is_null(catompool_find(&pool, "a.dev")));
+    catompool_drop(&pool);
+}
@@ -0,0 +1,77 @@
+#include "ctest.h"
+#include "stc/coroutine.h"
+
+typedef struct { catomic_isize sum, count; } Totals;
+
+cco_task_struct (Square) {
+    Square_state cco;
+    int x;
+};
+
+cco_task_struct (Work) {
+    Work_state cco;
+    int x, i;
+};
+
+cco_task_struct (Root) {
+    Root_state cco;
+    int n, i;
+    bool joined;
+};
+
+int Square(struct Square* self, cco_fiber* fb) {
+    cco_routine (self) {
+        cco_yield;
+        c_atomic_fetch_add(&((Totals *)fb->env)->sum, (isize)self->x*self->x);
+    }
+    free(self);
+    return 0;
+}
+
+int Work(struct Work* self, cco_fiber* fb) {
+    cco_routine (self) {
+        for (self->i = 0; self->i < 3; ++self->i)
+            cco_yield;
+        cco_await_task(cco_new_task(Square, self->x), fb);
+        if (self->x % 4 == 0) { // nested spawns; joined with the root
+            cco_spawn(cco_new_task(Square, 1), fb);
+            cco_spawn(cco_new_task(Square, 1), fb);
+        }
+        c_atomic_fetch_add(&((Totals *)fb->env)->count, 1);
+    }
+    free(self);
+    return 0;
+}
+
+int Root(struct Root* self, cco_fiber* fb) {
+    cco_routine (self) {
+        for (self->i = 0; self->i < self->n; ++self->i) {
+            cco_spawn(cco_new_task(Work, self->i), fb);
+            if (self->i % 16 == 0)
+                cco_yield;
+        }
+        cco_await(cco_is_joined(fb));
+        self->joined = c_atomic_load_acquire(&((Totals *)fb->env)->count) == self->n;
+    }
+    return 0;
+}
+
+TEST(coroutine, executor) {
+    enum {N = 1000};
+    long long expect = 0;
+    for (c_range(i, N)) expect += i*i + (i % 4 == 0)*2;
+
+    for (c_items(nworkers, int, {1, 4})) {
+        Totals totals = {0};
+        struct Root root = {{Root}, .n=N};
+        cco_executor* exec = cco_new_executor(*nworkers.ref);
+        ASSERT_TRUE(exec != NULL);
+        cco_executor_spawn(exec, &root, &totals);
+        cco_run_executor(exec);
+        cco_drop_executor(exec);
+
+        EXPECT_TRUE(root.joined);
+        EXPECT_EQ(N, (int)totals.count);
+        EXPECT_EQ(expect, (long long)totals.sum);
+    }
+}
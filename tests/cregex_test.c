@@ -328,4 +328,187 @@ TEST(cregex, utf8_bad_string)
     EXPECT_GT(0, utf8_icmp(bad, "tHiS iS bAd ��StRiNgX"));
     EXPECT_FALSE(utf8_valid(bad));
     EXPECT_TRUE(utf8_valid_n(bad, 12));
-}
\ No newline at end of file
+}
+static bool is_match_aio(const char* pattern, const char* input)
+{
+    cregex re = cregex_from(pattern);
+    bool ok = cregex_is_match(&re, input);
+    cregex_drop(&re);
+    return ok;
+}
+
+TEST(cregex, is_match_dfa)
+{
+    const char* input = "warn: disk\nerror: timeout";
+    cregex re = cregex_from("^error:.*\\btimeout$");
+    EXPECT_TRUE(cregex_is_match(&re, input));
+    EXPECT_FALSE(cregex_is_match(&re, "warn: error: timeout"));
+    csview match[1] = {{input, 10}}; // view ends before the second line
+    EXPECT_EQ(cregex_match_pro(&re, input, match, CREG_STARTEND), CREG_NOMATCH);
+    cregex_drop(&re);
+
+    EXPECT_FALSE(is_match_aio("c\\B", "abc-"));
+    EXPECT_TRUE(is_match_aio("c\\B", "abcd"));
+    EXPECT_TRUE(is_match_aio("x\\b", "x"));
+    EXPECT_TRUE(is_match_aio("(?s)a.b", "a\nb"));
+    EXPECT_TRUE(is_match_aio("\\d+\\.\\d+ ms", "took 12.5 ms"));
+    EXPECT_FALSE(is_match_aio("\\d+\\.\\d+ ms", "took 12. ms"));
+
+    // more dfa states than the cache holds: falls back to the nfa
+    char text[4001];
+    uint32_t x = 1;
+    for (int i = 0; i < 4000; ++i, x = x*1103515245 + 12345)
+        text[i] = "ab"[(x >> 16) & 1];
+    text[4000] = '\0';
+    EXPECT_FALSE(is_match_aio("a..........c", text));
+    EXPECT_TRUE(is_match_aio("a..........b", text));
+    text[3990] = '\0';
+    EXPECT_TRUE(is_match_aio("a.........[ab]$", text));
+}
+
+TEST(cregex, literal_skip)
+{
+    const char* input = "INFO start; ERROR disk; ERROR net timeout; done";
+    csview match[2];
+    cregex re = cregex_from("ERROR (\\w+) timeout");
+    EXPECT_EQ(cregex_match(&re, input, match), CREG_OK);
+    EXPECT_EQ(M_START(match[0]), 24);
+    EXPECT_TRUE(csview_equals(match[1], "net"));
+
+    match[0] = c_sv(input, 38); // view ends inside "timeout"
+    EXPECT_EQ(cregex_match_pro(&re, input, match, CREG_STARTEND), CREG_NOMATCH);
+    EXPECT_FALSE(cregex_is_match(&re, "ERROR net timeou"));
+    cregex_drop(&re);
+
+    re = cregex_from("(ab|x)+cd?é");
+    EXPECT_EQ(cregex_match(&re, input="xxabxcé abcé", match), CREG_OK);
+    EXPECT_EQ(M_START(match[0]), 0);
+    EXPECT_EQ(M_END(match[0]), 8);
+    EXPECT_EQ(cregex_match_next(&re, input, match), CREG_OK);
+    EXPECT_EQ(M_START(match[0]), 9);
+    EXPECT_EQ(cregex_match_next(&re, input, match), CREG_NOMATCH);
+    cregex_drop(&re);
+}
+
+TEST(cregex, truncated_rune_view)
+{
+    const char text[] = "x\xc3\xa9secret";
+    const csview view = {text, 2}; // ends inside the two-byte rune
+    csview match[1];
+    cregex re = cregex_from("x.*t");
+    EXPECT_EQ(cregex_match_sv(&re, view, match), CREG_NOMATCH);
+    cregex_drop(&re);
+
+    re = cregex_from("x.");
+    EXPECT_EQ(cregex_match_sv(&re, view, match), CREG_OK);
+    EXPECT_EQ(match[0].size, 2);
+    cregex_drop(&re);
+}
+
+TEST(cregex, set_match)
+{
+    const char* patterns[] = {"ERROR", "timeout$", "^\\d+ ", "\\w+@\\w+\\.com", "a(?i)BC"};
+    bool matched[5];
+    cregex_set set = cregex_set_make(patterns, 4, CREG_DEFAULT);
+    ASSERT_EQ(set.error, CREG_OK);
+    EXPECT_EQ(cregex_set_size(&set), 4);
+
+    EXPECT_EQ(cregex_set_match(&set, "12 ERROR: read timeout", matched), 3);
+    EXPECT_TRUE(matched[0] && matched[1] && matched[2] && !matched[3]);
+    EXPECT_EQ(cregex_set_match(&set, "mail to bob@example.com", matched), 1);
+    EXPECT_TRUE(matched[3]);
+    EXPECT_EQ(cregex_set_match(&set, "nothing here", matched), 0);
+    EXPECT_EQ(cregex_set_match_sv(&set, c_sv("ERROR timeout, retry", 13), matched), 2);
+    EXPECT_TRUE(matched[0] && matched[1]);
+    cregex_set_drop(&set);
+
+    const char* secret[] = {"secret"};
+    set = cregex_set_make(secret, 1, CREG_DEFAULT);
+    const char cut[] = "x\xc3\xa9secret";
+    EXPECT_EQ(cregex_set_match_sv(&set, c_sv(cut, 2), matched), 0); // ends inside a rune
+    cregex_set_drop(&set);
+    set = cregex_set_make(patterns, 4, CREG_DEFAULT);
+
+    const char* input = "to bob@example.com";
+    csview match[1];
+    EXPECT_EQ(cregex_match(cregex_set_get(&set, 3), input, match), CREG_OK);
+    EXPECT_EQ(M_START(match[0]), 3);
+    cregex_set_drop(&set);
+
+    // inline flags mid-pattern: matched pattern by pattern
+    set = cregex_set_make(patterns, 5, CREG_DEFAULT);
+    EXPECT_EQ(cregex_set_match(&set, "xaBc 7 ERROR", matched), 2);
+    EXPECT_TRUE(matched[0] && matched[4]);
+    cregex_set_drop(&set);
+
+    const char* bad[] = {"ok", "(unclosed"};
+    set = cregex_set_make(bad, 2, CREG_DEFAULT);
+    EXPECT_NE(set.error, CREG_OK);
+    EXPECT_EQ(cregex_set_get(&set, 0)->error, CREG_OK);
+    EXPECT_NE(cregex_set_get(&set, 1)->error, CREG_OK);
+    cregex_set_drop(&set);
+
+    // more dfa states than the cache holds: the cache is flushed and rebuilt
+    const char* wide[] = {"a.............c", "b.............a", "a............b$", "aaaaaaaaaaaaaa"};
+    char text[40001];
+    uint32_t x = 1;
+    for (int i = 0; i < 40000; ++i, x = x*1103515245 + 12345)
+        text[i] = "ab"[(x >> 16) & 1];
+    text[40000] = '\0';
+    set = cregex_set_make(wide, 4, CREG_DEFAULT);
+    ASSERT_EQ(set.error, CREG_OK);
+    int n = cregex_set_match(&set, text, matched);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(matched[i], cregex_is_match(cregex_set_get(&set, i), text));
+        n -= matched[i];
+    }
+    EXPECT_EQ(n, 0);
+    cregex_set_drop(&set);
+}
+
+TEST(cregex, stream)
+{
+    const char* input = "mail bob@example.com, ann@test.com";
+    cregex re = cregex_from("(\\w+)@(\\w+)\\.com\\b");
+    cregex_stream st = cregex_stream_init(&re);
+    csview match[3];
+    const char* chunks[] = {"mail bo", "b@exam", "ple.com, ann@te", "st.co", "m"};
+    int n = 0;
+    for (int i = 0; i < 5; ++i) {
+        cregex_stream_feed(&st, c_sv(chunks[i], c_strlen(chunks[i])));
+        while (cregex_stream_next(&st, match) == CREG_OK) {
+            EXPECT_TRUE(csview_equals(match[1], "bob"));
+            EXPECT_TRUE(csview_equals(match[2], "example"));
+            EXPECT_EQ(cregex_stream_offset(&st, match[0].buf), 5);
+            ++n;
+        }
+    }
+    EXPECT_EQ(n, 1);
+    // the second match ends the input: \b needs to know it is the end
+    cregex_stream_close(&st);
+    EXPECT_EQ(cregex_stream_next(&st, match), CREG_OK);
+    EXPECT_TRUE(csview_equals(match[1], "ann"));
+    EXPECT_EQ(cregex_stream_offset(&st, match[0].buf), strstr(input, "ann") - input);
+    EXPECT_EQ(cregex_stream_next(&st, match), CREG_NOMATCH);
+    cregex_stream_drop(&st);
+    cregex_drop(&re);
+
+    // read from a file, with matches across the read blocks
+    FILE* fp = tmpfile();
+    ASSERT_TRUE(fp != NULL);
+    for (int i = 0; i < 20000; ++i)
+        fprintf(fp, "line %d%s\n", i, i % 1000 == 999 ? " ERROR: disk timeout" : "");
+    rewind(fp);
+    re = cregex_from("^line (\\d+) ERROR: (.*)$");
+    st = cregex_stream_init(&re);
+    n = 0;
+    while (cregex_stream_next_file(&st, fp, match) == CREG_OK) {
+        EXPECT_EQ(atoi(match[1].buf), n*1000 + 999);
+        EXPECT_TRUE(csview_equals(match[2], "disk timeout"));
+        ++n;
+    }
+    EXPECT_EQ(n, 20);
+    cregex_stream_drop(&st);
+    cregex_drop(&re);
+    fclose(fp);
+}
@@ -0,0 +1,85 @@
+#include "ctest.h"
+#include "stc/crope.h"
+#include "stc/cstr.h"
+#include "stc/random.h"
+
+static bool rope_equals(const crope* r, const cstr* s) {
+    isize n = 0;
+    for (c_range(i, crope_piece_count(r))) {
+        csview p = crope_pieces(r)[i];
+        if (p.size == 0 || c_memcmp(p.buf, cstr_str(s) + n, p.size)) return false;
+        n += p.size;
+    }
+    return n == crope_size(r) && n == cstr_size(s);
+}
+
+TEST(crope, build) {
+    crope r = crope_init();
+    cstr ref = cstr_init();
+    static char big[3*crope_CHUNK_SIZE];
+    for (c_range(i, c_arraylen(big))) big[i] = 'a' + i % 26;
+    const char* ext = "<external>";
+    crand64_seed(1234);
+
+    for (c_range(round, 2)) {
+        for (c_range(i, 3000)) {
+            isize pos = (isize)(crand64_uint() % (uint64_t)(cstr_size(&ref) + 1));
+            switch (crand64_uint() % 8) {
+                case 0: case 1:
+                    crope_append(&r, "hello ");
+                    cstr_append(&ref, "hello ");
+                    break;
+                case 2: {
+                    int n = (int)(i*1000003 % 2000000000) - 1000000000;
+                    EXPECT_EQ(cstr_append_fmt(&ref, "%d:%s,", n, "fmt"), crope_append_fmt(&r, "%d:%s,", n, "fmt"));
+                    break;
+                }
+                case 3:
+                    crope_append_ref(&r, c_sv_2(ext, 10));
+                    cstr_append(&ref, ext);
+                    break;
+                case 4: {
+                    isize n = (isize)(crand64_uint() % (i % 50 == 0 ? c_arraylen(big) : 40));
+                    crope_append_n(&r, big, n);
+                    cstr_append_n(&ref, big, n);
+                    break;
+                }
+                case 5: case 6:
+                    crope_insert(&r, pos, "[ins]");
+                    cstr_insert(&ref, pos, "[ins]");
+                    break;
+                case 7:
+                    crope_insert_ref(&r, pos, c_sv_2(ext, 10));
+                    cstr_insert(&ref, pos, ext);
+                    break;
+            }
+        }
+        ASSERT_TRUE(rope_equals(&r, &ref));
+        cstr flat = crope_to_cstr(&r);
+        EXPECT_TRUE(cstr_eq(&flat, &ref));
+        cstr_drop(&flat);
+
+        char buf[64] = {0};
+        isize pos = cstr_size(&ref)/2;
+        EXPECT_EQ(40, crope_copy(&r, pos, buf, 40));
+        EXPECT_EQ(0, c_memcmp(buf, cstr_str(&ref) + pos, 40));
+        EXPECT_EQ(5, crope_copy(&r, cstr_size(&ref) - 5, buf, 40));
+
+        crope_clear(&r);
+        cstr_clear(&ref);
+        EXPECT_TRUE(crope_is_empty(&r));
+        EXPECT_EQ(0, crope_piece_count(&r));
+    }
+    // consecutive appends into a chunk extend one piece
+    crope_append(&r, "GET / HTTP/1.1\r\n");
+    crope_append_fmt(&r, "Content-Length: %d\r\n", 42);
+    crope_append(&r, "\r\n");
+    EXPECT_EQ(1, crope_piece_count(&r));
+    crope_insert(&r, 0, "> ");
+    EXPECT_EQ(2, crope_piece_count(&r));
+    cstr flat = crope_to_cstr(&r);
+    EXPECT_STREQ("> GET / HTTP/1.1\r\nContent-Length: 42\r\n\r\n", cstr_str(&flat));
+    cstr_drop(&flat);
+    crope_drop(&r);
+    cstr_drop(&ref);
+}
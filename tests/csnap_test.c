@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include "ctest.h"
+
+#define i_type IMap, int, double
+#define i_snapshot
+#include "stc/hmap.h"
+
+#define i_type HMap, long long, int
+#define i_store_hash
+#define i_snapshot
+#include "stc/hmap.h"
+
+#define i_type SMap, int, int
+#define i_snapshot
+#include "stc/smap.h"
+
+#define i_type FVec, float
+#define i_snapshot
+#include "stc/vec.h"
+
+static const char* path = "csnap_test.snap";
+
+TEST(csnap, hmap) {
+    IMap map = {0};
+    for (c_range32(i, 20000))
+        IMap_insert(&map, i*7, i/2.0);
+    ASSERT_TRUE(IMap_write_snapshot(&map, path));
+
+    csnap snap = csnap_open(path);
+    ASSERT_TRUE(csnap_is_open(&snap));
+    IMap view = {0};
+    ASSERT_TRUE(IMap_view_snapshot(&view, &snap));
+    EXPECT_EQ(20000, IMap_size(&view));
+    EXPECT_EQ(IMap_bucket_count(&map), IMap_bucket_count(&view));
+    EXPECT_TRUE(IMap_contains(&view, 7*123));
+    EXPECT_FALSE(IMap_contains(&view, 7*123 + 1));
+    EXPECT_DOUBLE_EQ(123/2.0, *IMap_at(&view, 7*123));
+    isize n = 0;
+    for (c_each(i, IMap, view))
+        n += i.ref->first % 7 == 0;
+    EXPECT_EQ(20000, n);
+
+    HMap other = {0};
+    EXPECT_FALSE(HMap_view_snapshot(&other, &snap)); // other container type
+
+    // replacing the file leaves the open snapshot valid
+    IMap_clear(&map);
+    IMap_insert(&map, 1, 1.0);
+    ASSERT_TRUE(IMap_write_snapshot(&map, path));
+    EXPECT_TRUE(IMap_contains(&view, 7*19999));
+    csnap_close(&snap);
+
+    snap = csnap_open(path);
+    ASSERT_TRUE(IMap_view_snapshot(&view, &snap));
+    EXPECT_EQ(1, IMap_size(&view));
+    EXPECT_DOUBLE_EQ(1.0, *IMap_at(&view, 1));
+    csnap_close(&snap);
+    IMap_drop(&map);
+    remove(path);
+
+    snap = csnap_open(path);
+    EXPECT_FALSE(csnap_is_open(&snap));
+}
+
+TEST(csnap, hmap_hashed) {
+    HMap map = {0};
+    for (c_range32(i, 5000))
+        HMap_insert(&map, (long long)i*i, i);
+    HMap_erase(&map, 49);
+    ASSERT_TRUE(HMap_write_snapshot(&map, path));
+    HMap_drop(&map);
+
+    csnap snap = csnap_open(path);
+    HMap view = {0};
+    ASSERT_TRUE(HMap_view_snapshot(&view, &snap));
+    EXPECT_EQ(4999, HMap_size(&view));
+    EXPECT_EQ(4999, *HMap_at(&view, 4999LL*4999));
+    EXPECT_FALSE(HMap_contains(&view, 49));
+    const long long keys[] = {0, 1, 2, 4, 49};
+    bool found[5];
+    EXPECT_EQ(3, HMap_contains_n(&view, keys, 5, found));
+    EXPECT_EQ(HMap_stats(&view).size, 4999);
+    csnap_close(&snap);
+    remove(path);
+}
+
+TEST(csnap, smap_vec) {
+    SMap tree = {0};
+    for (c_range32(i, 1000))
+        SMap_insert(&tree, (i*37) % 1000, i);
+    SMap_erase(&tree, 500);
+    ASSERT_TRUE(SMap_write_snapshot(&tree, path));
+
+    csnap snap = csnap_open(path);
+    SMap view = {0};
+    ASSERT_TRUE(SMap_view_snapshot(&view, &snap));
+    EXPECT_EQ(999, SMap_size(&view));
+    EXPECT_FALSE(SMap_contains(&view, 500));
+    EXPECT_EQ(*SMap_at(&tree, 37), *SMap_at(&view, 37));
+    int prev = -1, n = 0;
+    for (c_each(i, SMap, view)) {
+        EXPECT_TRUE(i.ref->first > prev);
+        prev = i.ref->first, ++n;
+    }
+    EXPECT_EQ(999, n);
+    EXPECT_EQ(999, SMap_lower_bound(&view, 999).ref->first);
+    csnap_close(&snap);
+    SMap_drop(&tree);
+
+    FVec vec = {0};
+    for (c_range(i, 100))
+        FVec_push(&vec, (float)i*0.5f);
+    ASSERT_TRUE(FVec_write_snapshot(&vec, path));
+    FVec_drop(&vec);
+
+    snap = csnap_open(path);
+    FVec fview = {0};
+    EXPECT_FALSE(SMap_view_snapshot(&view, &snap));
+    ASSERT_TRUE(FVec_view_snapshot(&fview, &snap));
+    EXPECT_EQ(100, FVec_size(&fview));
+    EXPECT_FLOAT_EQ(49.5f, *FVec_at(&fview, 99));
+    csnap_close(&snap);
+    remove(path);
+}
@@ -0,0 +1,110 @@
+#include "ctest.h"
+#include "stc/cstr.h"
+#include "stc/csview.h"
+#include "stc/random.h"
+
+static isize naive_find(csview sv, csview needle) {
+    for (isize i = 0; i + needle.size <= sv.size; ++i)
+        if (!c_memcmp(sv.buf + i, needle.buf, needle.size)) return i;
+    return c_NPOS;
+}
+
+TEST(csview, find) {
+    enum {N = 300};
+    char text[N];
+    crand64_seed(1234);
+    // small alphabet: many partial matches for the prefilter to reject
+    for (c_range(i, N)) text[i] = "abc "[crand64_uint() & 3];
+
+    for (c_range(n, 1, 40)) {
+        for (c_range(trial, 20)) {
+            isize start = (isize)(crand64_uint() % (N - n));
+            csview needle = {text + start, n};
+            csview_searcher srch = csview_searcher_from(needle);
+            for (c_range(off, 0, 40, 7)) {
+                csview sv = {text + off, N - off};
+                isize expect = naive_find(sv, needle);
+                EXPECT_EQ(expect, csview_find_sv(sv, needle));
+                EXPECT_EQ(expect, csview_searcher_find(&srch, sv));
+            }
+        }
+    }
+    csview sv = c_sv("The quick brown fox jumps over the lazy dog, status=500 later");
+    csview_searcher srch = csview_searcher_from(c_sv("status=500"));
+    EXPECT_EQ(csview_find(sv, "status=500"), csview_searcher_find(&srch, sv));
+    EXPECT_EQ(45, csview_searcher_find(&srch, sv));
+    EXPECT_FALSE(csview_searcher_contains(&srch, csview_subview(sv, 0, 53)));
+    EXPECT_EQ(0, csview_find(sv, ""));
+    EXPECT_EQ(c_NPOS, csview_find(c_sv("ab"), "abc"));
+}
+
+TEST(csview, u8_valid_size) {
+    const char* text = "All work and no play makes Jack a dull boy. All work and no play.";
+    const char* good[] = {"é", "€", "𝄞", "\xF4\x8F\xBF\xBF", "\xED\x9F\xBF", "\xE0\xA0\x80"};
+    const char* bad[] = {"\x80", "\xFF", "\xC0\x80", "\xE2\x82", "\xED\xA0\x80",
+                         "\xE0\x9F\xBF", "\xF0\x8F\xBF\xBF", "\xF4\x90\x80\x80", "é\xA9"};
+    char buf[128];
+    // place each sequence across every offset of a 16-byte block
+    for (c_range(pos, 40)) {
+        for (c_range(i, c_arraylen(good))) {
+            isize n = c_strlen(good[i]);
+            memcpy(buf, text, (size_t)pos);
+            memcpy(buf + pos, good[i], (size_t)n);
+            strcpy(buf + pos + n, text + pos);
+            csview sv = c_sv(buf, c_strlen(buf));
+            EXPECT_TRUE(csview_u8_valid(sv));
+            EXPECT_EQ(c_strlen(text) + 1, csview_u8_size(sv));
+            EXPECT_FALSE(csview_u8_valid(csview_subview(sv, 0, pos + n - 1))); // truncated
+        }
+        for (c_range(i, c_arraylen(bad))) {
+            isize n = c_strlen(bad[i]);
+            memcpy(buf, text, (size_t)pos);
+            memcpy(buf + pos, bad[i], (size_t)n);
+            strcpy(buf + pos + n, text + pos);
+            EXPECT_FALSE(csview_u8_valid(c_sv(buf, c_strlen(buf))));
+        }
+    }
+    // stops at NUL
+    EXPECT_TRUE(csview_u8_valid(c_sv("valid part\0\xFF", 12)));
+    EXPECT_EQ(10, csview_u8_size(c_sv("valid part\0\xFF", 12)));
+    // a view which is not NUL-terminated is not read past its end
+    char* raw = (char*)c_malloc(6);
+    memcpy(raw, "h\xC3\xA9llo", 6);
+    EXPECT_EQ(5, csview_u8_size(c_sv(raw, 6)));
+    EXPECT_TRUE(csview_u8_valid(c_sv(raw, 6)));
+    c_free(raw, 6);
+}
+
+TEST(csview, icase) {
+    const char* upper = "CONTENT-TYPE: TEXT/HTML; CHARSET=UTF-8 [SOME LONGER ASCII TEXT @ THE END]";
+    const char* lower = "content-type: text/html; charset=utf-8 [some longer ascii text @ the end]";
+    char buf[128];
+    EXPECT_TRUE(csview_iequals(c_sv(upper, c_strlen(upper)), lower));
+    // a single difference at every offset, on both sides of the 16-byte blocks
+    for (c_range(i, c_strlen(lower))) {
+        strcpy(buf, lower);
+        buf[i] = '~';
+        csview a = c_sv(upper, c_strlen(upper)), b = c_sv(buf, c_strlen(buf));
+        EXPECT_FALSE(csview_iequals(a, buf));
+        EXPECT_EQ(utf8_icompare(a, b) < 0, '~' > lower[i]);
+        EXPECT_EQ(utf8_icmp(upper, buf) < 0, '~' > lower[i]);
+        EXPECT_TRUE(utf8_icompare(csview_subview(a, 0, i), csview_subview(b, 0, i)) == 0);
+    }
+    // '@' '[' '`' '{' are not letters
+    EXPECT_FALSE(csview_iequals(c_sv("@[`{"), "`{@["));
+    // non-ascii runes, including KELVIN SIGN and LONG S which fold to ascii letters
+    EXPECT_TRUE(csview_iequals(c_sv("CONTENT-TYPE: ÆØÅ"), "content-type: æøå"));
+    EXPECT_EQ(0, utf8_icmp("CONTENT-TYPE: \xE2\x84\xAAILO, ſTRASSE", "content-type: kilo, Strasse"));
+    EXPECT_FALSE(csview_iequals(c_sv("CONTENT-TYPE: ÆØÅ"), "content-type: æøa"));
+    EXPECT_TRUE(utf8_icmp("ABC", "abcd") < 0);
+    EXPECT_TRUE(utf8_icmp("abcd", "ABC") > 0);
+
+    csview sv = c_sv(upper, c_strlen(upper));
+    cstr s = cstr_tolower_sv(sv);
+    EXPECT_STREQ(lower, cstr_str(&s));
+    cstr_take(&s, cstr_toupper_sv(cstr_sv(&s)));
+    EXPECT_STREQ(upper, cstr_str(&s));
+    cstr_take(&s, cstr_tolower("ÆØÅ AND SOME ASCII TEXT BEYOND SIXTEEN BYTES \xFF\xFF\xFF\xFF\xFF"));
+    EXPECT_STREQ("æøå and some ascii text beyond sixteen bytes \xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD", cstr_str(&s));
+    cstr_drop(&s);
+}
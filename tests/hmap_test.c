@@ -58,3 +58,287 @@ TEST(hmap, mapdemo3)
 
     c_drop(hmap_cstr, &map, &res1, &res2);
 }
+
+#define i_type hset_simd, int
+#define i_hash(x) ((size_t)*(x) / 4) // clustered: produces long probe sequences
+#define i_simd_probe
+#include "stc/hashset.h"
+
+TEST(hmap, simd_probe)
+{
+    hset_simd set = {0};
+    for (c_range32(i, 1000))
+        hset_simd_insert(&set, i*3);
+    for (c_range32(i, 0, 1000, 2))
+        hset_simd_erase(&set, i*3);
+
+    EXPECT_EQ(500, hset_simd_size(&set));
+    int found = 0;
+    for (c_range32(i, 3000)) {
+        bool expect = i % 3 == 0 && (i/3) % 2 == 1;
+        found += expect;
+        EXPECT_EQ(expect, hset_simd_contains(&set, i));
+    }
+    EXPECT_EQ(500, found);
+    hset_simd_drop(&set);
+}
+
+#define i_type hmap_incr, int, int
+#define i_incremental_rehash
+#define i_rehash_steps 2
+#include "stc/hashmap.h"
+
+TEST(hmap, incremental_rehash)
+{
+    hmap_incr map = {0}, copy = {0};
+    for (c_range32(i, 5000)) {
+        hmap_incr_insert(&map, i, i*2);
+        if (i % 7 == 0)
+            hmap_incr_erase(&map, i/2);
+        if (i == 3333) // in the middle of a migration
+            copy = hmap_incr_clone(map);
+    }
+    for (c_range32(i, 5000)) {
+        bool erased = i < 2500 && ((i*2) % 7 == 0 || (i*2 + 1) % 7 == 0);
+        EXPECT_EQ(!erased, hmap_incr_contains(&map, i));
+        if (!erased) EXPECT_EQ(i*2, *hmap_incr_at(&map, i));
+    }
+    EXPECT_EQ(5000 - 715, hmap_incr_size(&map));
+
+    isize n = 0;
+    for (c_each(i, hmap_incr, copy)) {
+        EXPECT_EQ(i.ref->first*2, i.ref->second);
+        ++n;
+    }
+    EXPECT_EQ(hmap_incr_size(&copy), n);
+    EXPECT_TRUE(hmap_incr_contains(&copy, 3333));
+    EXPECT_FALSE(hmap_incr_contains(&copy, 3334));
+
+    // iteration covers both tables without migrating; erase migrates
+    hmap_incr_clear(&map);
+    int k = 0;
+    while (hmap_incr_stats(&map).extra_bytes == 0 || hmap_incr_size(&map) < 1000)
+        hmap_incr_insert(&map, k, k*2), ++k;
+    const isize pending = hmap_incr_stats(&map).extra_bytes;
+    n = 0;
+    for (c_each(i, hmap_incr, map))
+        n += i.ref->first*2 == i.ref->second;
+    EXPECT_EQ(k, n);
+    EXPECT_EQ(pending, hmap_incr_stats(&map).extra_bytes);
+    for (int i = 0; hmap_incr_stats(&map).extra_bytes != 0; ++i)
+        EXPECT_EQ(1, hmap_incr_erase(&map, i));
+    EXPECT_GT(hmap_incr_size(&map), 0);
+    for (c_range32(i, k))
+        EXPECT_EQ(i >= k - hmap_incr_size(&map), hmap_incr_contains(&map, i));
+
+    c_drop(hmap_incr, &map, &copy);
+}
+
+static int alloc_budget = -1; // number of allocations that succeed, or -1
+static void* lim_malloc(isize sz)
+    { return alloc_budget == 0 ? NULL : (alloc_budget -= alloc_budget > 0, c_malloc(sz)); }
+#define lim_calloc(n, sz) c_calloc(n, sz)
+#define lim_realloc(p, old_sz, sz) c_realloc(p, old_sz, sz)
+#define lim_free(p, sz) c_free(p, sz)
+
+#define i_type hmap_lim
+#define i_key int
+#define i_valpro cstr
+#define i_incremental_rehash
+#define i_allocator lim
+#include "stc/hashmap.h"
+
+TEST(hmap, clone_out_of_memory)
+{
+    hmap_lim map = {0};
+    int k = 0;
+    while (hmap_lim_stats(&map).extra_bytes == 0 || hmap_lim_size(&map) < 100)
+        hmap_lim_insert(&map, k, cstr_from_fmt("a value which is too long for SSO: %d", k)), ++k;
+
+    alloc_budget = 2; // the new table is cloned, the old one is not
+    hmap_lim copy = hmap_lim_clone(map);
+    EXPECT_EQ(0, hmap_lim_size(&copy));
+    EXPECT_FALSE(hmap_lim_contains(&copy, 0));
+    hmap_lim_drop(&copy);
+
+    alloc_budget = -1;
+    copy = hmap_lim_clone(map);
+    EXPECT_EQ(k, hmap_lim_size(&copy));
+    for (c_range32(i, k))
+        EXPECT_TRUE(hmap_lim_contains(&copy, i));
+    c_drop(hmap_lim, &map, &copy);
+}
+
+TEST(hmap, string_keys)
+{
+    hmap_si map = {0};
+    char buf[64];
+    for (c_range32(i, 20000)) {
+        snprintf(buf, sizeof buf, "key-%d-with-long-suffix", i);
+        hmap_si_emplace(&map, buf, i);
+    }
+    EXPECT_EQ(20000, hmap_si_size(&map));
+    for (c_range32(i, 20000)) {
+        snprintf(buf, sizeof buf, "key-%d-with-long-suffix", i);
+        const hmap_si_value* v = hmap_si_get(&map, buf);
+        ASSERT_TRUE(v != NULL);
+        EXPECT_EQ(i, v->second);
+    }
+    hmap_si_drop(&map);
+}
+
+#define i_type hset_seed, int
+#define i_hash(x) (size_t)c_hash_seed_n(x, sizeof *(x), 0x9e3779b97f4a7c15)
+#include "stc/hashset.h"
+
+TEST(hmap, hash_seed)
+{
+    char buf[100] = {0};
+    for (c_range(n, 101)) {
+        uint64_t h = c_hash_seed_n(buf, n, 1);
+        EXPECT_NE(h, c_hash_seed_n(buf, n, 2));
+        if (n > 0) {
+            buf[n - 1] = 'x'; // every byte of the key affects the hash
+            EXPECT_NE(h, c_hash_seed_n(buf, n, 1));
+            buf[n - 1] = 0;
+        }
+        if (n >= 8) { // and so does the first one
+            buf[0] = 'y';
+            EXPECT_NE(h, c_hash_seed_n(buf, n, 1));
+            buf[0] = 0;
+        }
+    }
+
+    hset_seed set = {0};
+    for (c_range32(i, 10000)) hset_seed_insert(&set, i*3);
+    EXPECT_EQ(10000, hset_seed_size(&set));
+    for (c_range32(i, 30000))
+        EXPECT_EQ(i % 3 == 0, hset_seed_contains(&set, i));
+    hset_seed_drop(&set);
+}
+
+TEST(hmap, get_n)
+{
+    hmap_incr map = {0};
+    int keys[100];
+    const hmap_incr_value* refs[100];
+    bool found[100];
+    EXPECT_EQ(0, hmap_incr_get_n(&map, keys, 0, refs));
+
+    for (c_range32(i, 1000)) {
+        hmap_incr_insert(&map, i*2, i);
+        if (i % 100 == 99) { // also while rehashing incrementally
+            for (c_range32(k, 100)) keys[k] = (k*37 + i) % 2000;
+            isize n = 0;
+            for (c_range32(k, 100)) n += keys[k] % 2 == 0 && keys[k] <= i*2;
+            EXPECT_EQ(n, hmap_incr_get_n(&map, keys, 100, refs));
+            EXPECT_EQ(n, hmap_incr_contains_n(&map, keys, 100, found));
+            for (c_range32(k, 100)) {
+                EXPECT_TRUE(hmap_incr_get(&map, keys[k]) == refs[k]);
+                EXPECT_EQ(refs[k] != NULL, found[k]);
+            }
+        }
+    }
+    hmap_incr_drop(&map);
+}
+
+#define i_type hmap_sh
+#define i_keypro cstr
+#define i_val int
+#define i_store_hash
+#define i_simd_probe
+#include "stc/hashmap.h"
+
+#define i_type hset_sh
+#define i_keypro cstr
+#define i_store_hash
+#include "stc/hashset.h"
+
+TEST(hmap, hashed)
+{
+    hmap_sh map = {0};
+    hset_sh set = {0};
+    char buf[32];
+    for (c_range32(i, 5000)) {
+        snprintf(buf, sizeof buf, "key%d", i);
+        const size_t h = hmap_sh_key_hash(buf); // hash once, use for both
+        EXPECT_EQ(h, hset_sh_key_hash(buf));
+        EXPECT_TRUE(hmap_sh_emplace_hashed(&map, buf, i, h).inserted);
+        EXPECT_FALSE(hmap_sh_insert_hashed(&map, cstr_from(buf), -1, h).inserted);
+        hset_sh_emplace_hashed(&set, buf, h);
+        if (i % 3 == 0) {
+            snprintf(buf, sizeof buf, "key%d", i/3);
+            EXPECT_EQ(1, hmap_sh_erase(&map, buf));
+            EXPECT_EQ(1, hset_sh_erase(&set, buf));
+        }
+    }
+    hmap_sh copy = hmap_sh_clone(map);
+    hmap_sh_reserve(&map, 20000);
+    hset_sh_shrink_to_fit(&set);
+    EXPECT_EQ(hmap_sh_size(&map), hset_sh_size(&set));
+
+    for (c_range32(i, 5000)) {
+        snprintf(buf, sizeof buf, "key%d", i);
+        const size_t h = hmap_sh_key_hash(buf);
+        const bool erased = i < 5000/3 + 1 && i*3 < 5000;
+        const hmap_sh_value* v = hmap_sh_get_hashed(&map, buf, h);
+        EXPECT_EQ(!erased, v != NULL);
+        if (v) EXPECT_EQ(i, v->second);
+        EXPECT_EQ(!erased, hmap_sh_find_hashed(&copy, buf, h).ref != NULL);
+        EXPECT_EQ(!erased, hset_sh_contains(&set, buf));
+    }
+    for (c_each(i, hset_sh, set))
+        EXPECT_TRUE(hmap_sh_contains(&map, cstr_str(i.ref)));
+
+    c_drop(hmap_sh, &map, &copy);
+    hset_sh_drop(&set);
+}
+
+#define i_type hset_bad, int
+#define i_hash(x) ((void)(x), (size_t)7) // every key has the same home bucket
+#define i_stats
+#include "stc/hashset.h"
+
+TEST(hmap, stats)
+{
+    hmap_ii map = {0};
+    hmap_stats st = hmap_ii_stats(&map);
+    EXPECT_EQ(0, st.bucket_count);
+    EXPECT_EQ(-1, st.rehashes);
+
+    for (c_range32(i, 1000))
+        hmap_ii_insert(&map, i*7919, i);
+    st = hmap_ii_stats(&map);
+    isize n = 0;
+    for (c_range(i, hmap_STATS_BINS))
+        n += st.dist_hist[i];
+    EXPECT_EQ(1000, n);
+    EXPECT_EQ(1000, st.size);
+    EXPECT_TRUE(st.avg_dist < 2.0f);
+    EXPECT_TRUE(st.max_dist < 32);
+    EXPECT_FALSE(st.dist_warning);
+    EXPECT_EQ(st.bucket_count*c_sizeof(hmap_ii_value), st.table_bytes);
+    EXPECT_EQ((st.bucket_count + 1)*c_sizeof(struct hmap_meta), st.meta_bytes);
+    EXPECT_EQ(0, st.extra_bytes);
+    hmap_ii_drop(&map);
+
+    hset_bad set = {0};
+    for (c_range32(i, hmap_DIST_WARN + 1))
+        hset_bad_insert(&set, i);
+    st = hset_bad_stats(&set);
+    EXPECT_EQ(hmap_DIST_WARN, st.max_dist);
+    EXPECT_EQ(hmap_DIST_WARN, st.peak_dist);
+    EXPECT_TRUE(st.avg_dist == (float)hmap_DIST_WARN/2); // PSLs are 0, 1, .., hmap_DIST_WARN
+    EXPECT_EQ(1, st.dist_hist[0]);
+    EXPECT_EQ(hmap_DIST_WARN + 1 - (hmap_STATS_BINS - 1), st.dist_hist[hmap_STATS_BINS - 1]);
+    EXPECT_TRUE(st.dist_warning);
+    EXPECT_TRUE(st.rehashes > 3);
+
+    for (c_range32(i, 100, hmap_DIST_WARN + 1))
+        hset_bad_erase(&set, i);
+    st = hset_bad_stats(&set);
+    EXPECT_EQ(99, st.max_dist);
+    EXPECT_EQ(hmap_DIST_WARN, st.peak_dist); // remembered
+    EXPECT_TRUE(st.dist_warning);
+    hset_bad_drop(&set);
+}
@@ -0,0 +1,112 @@
+#include "ctest.h"
+#include "stc/cstr.h"
+
+#define i_type MQueue, int
+#include "stc/mpmc_queue.h"
+
+#define i_type SQueue
+#define i_keypro cstr
+#include "stc/mpmc_queue.h"
+
+TEST(mpmc_queue, basics) {
+    MQueue q = MQueue_with_capacity(6);
+    EXPECT_EQ(8, MQueue_capacity(&q));
+    EXPECT_TRUE(MQueue_is_empty(&q));
+
+    for (c_range32(i, 8))
+        EXPECT_TRUE(MQueue_try_push(&q, i));
+    EXPECT_FALSE(MQueue_try_push(&q, 8));
+    EXPECT_EQ(8, MQueue_size(&q));
+
+    int x = -1, out[8];
+    EXPECT_TRUE(MQueue_try_pop(&q, &x));
+    EXPECT_EQ(0, x);
+    EXPECT_EQ(7, MQueue_try_pop_n(&q, out, 8));
+    EXPECT_EQ(1, out[0]);
+    EXPECT_EQ(7, out[6]);
+    EXPECT_FALSE(MQueue_try_pop(&q, &x));
+
+    int in[] = {10, 11, 12, 13, 14, 15, 16, 17, 18, 19};
+    EXPECT_EQ(3, MQueue_try_push_n(&q, in, 3));
+    EXPECT_EQ(5, MQueue_try_push_n(&q, in + 3, 7)); // wraps around, then full
+    EXPECT_EQ(2, MQueue_try_pop_n(&q, out, 2));
+    EXPECT_EQ(11, out[1]);
+    EXPECT_EQ(2, MQueue_try_push_n(&q, in + 8, 2));
+    EXPECT_EQ(8, MQueue_try_pop_n(&q, out, 8));
+    EXPECT_EQ(12, out[0]);
+    EXPECT_EQ(19, out[7]);
+    MQueue_drop(&q);
+}
+
+TEST(mpmc_queue, strings) {
+    SQueue q = SQueue_with_capacity(4);
+    for (c_items(i, const char*, {"one", "two", "three", "four", "five"}))
+        SQueue_try_emplace(&q, *i.ref);
+    EXPECT_EQ(4, SQueue_size(&q));
+    EXPECT_TRUE(SQueue_try_pop(&q, NULL));
+
+    cstr s;
+    EXPECT_TRUE(SQueue_try_pop(&q, &s));
+    EXPECT_STREQ("two", cstr_str(&s));
+    cstr_drop(&s);
+    SQueue_drop(&q); // drops "three" and "four"
+}
+
+#if !defined __STDC_NO_THREADS__
+#include <threads.h>
+
+enum {N_PRODUCERS = 4, N_CONSUMERS = 4, N_ITEMS = 20000};
+static struct { MQueue q; long long sum[N_CONSUMERS]; int count[N_CONSUMERS]; } shared;
+
+static int producer(void* arg) {
+    int id = (int)(intptr_t)arg, batch[16], n = 0;
+    for (int i = id; i < N_ITEMS; i += N_PRODUCERS) {
+        batch[n++] = i;
+        if (n == c_arraylen(batch) || i + N_PRODUCERS >= N_ITEMS) {
+            for (int k, done = 0; done < n; done += k)
+                if ((k = (int)MQueue_try_push_n(&shared.q, batch + done, n - done)) == 0)
+                    thrd_yield();
+            n = 0;
+        }
+    }
+    return 0;
+}
+
+static int consumer(void* arg) {
+    int id = (int)(intptr_t)arg, out[16];
+    bool stop = false;
+    while (!stop) {
+        isize n = MQueue_try_pop_n(&shared.q, out, c_arraylen(out));
+        if (n == 0) thrd_yield();
+        for (c_range(i, n)) {
+            if (out[i] >= 0) {
+                shared.sum[id] += out[i];
+                ++shared.count[id];
+            } else if (stop) { // hand over stop signals meant for other consumers
+                while (!MQueue_try_push(&shared.q, -1)) thrd_yield();
+            } else {
+                stop = true;
+            }
+        }
+    }
+    return 0;
+}
+
+TEST(mpmc_queue, threads) {
+    thrd_t prod[N_PRODUCERS], cons[N_CONSUMERS];
+    shared.q = MQueue_with_capacity(256);
+    for (c_range(i, N_CONSUMERS)) thrd_create(&cons[i], consumer, (void*)(intptr_t)i);
+    for (c_range(i, N_PRODUCERS)) thrd_create(&prod[i], producer, (void*)(intptr_t)i);
+    for (c_range(i, N_PRODUCERS)) thrd_join(prod[i], NULL);
+    for (c_range(N_CONSUMERS))
+        while (!MQueue_try_push(&shared.q, -1)) thrd_yield();
+    for (c_range(i, N_CONSUMERS)) thrd_join(cons[i], NULL);
+
+    long long sum = 0;
+    int count = 0;
+    for (c_range(i, N_CONSUMERS)) sum += shared.sum[i], count += shared.count[i];
+    EXPECT_EQ(N_ITEMS, count);
+    EXPECT_EQ((long long)N_ITEMS*(N_ITEMS - 1)/2, sum);
+    MQueue_drop(&shared.q);
+}
+#endif
@@ -0,0 +1,158 @@
+#include "ctest.h"
+#include "stc/cstr.h"
+
+#define i_type IMap, int, int
+#define i_shards 8
+#include "stc/sync_map.h"
+
+#define i_type SMap
+#define i_keypro cstr
+#define i_valpro cstr
+#define i_store_hash
+#include "stc/sync_map.h"
+
+static bool alloc_fails = false;
+static void* oom_malloc(isize sz) { return alloc_fails ? NULL : c_malloc(sz); }
+static void* oom_calloc(isize n, isize sz) { return alloc_fails ? NULL : c_calloc(n, sz); }
+#define oom_realloc(p, old_sz, sz) c_realloc(p, old_sz, sz)
+#define oom_free(p, sz) c_free(p, sz)
+
+#define i_type OMap
+#define i_key int
+#define i_valpro cstr
+#define i_shards 2
+#define i_allocator oom
+#include "stc/sync_map.h"
+
+static void add(int* value, bool inserted, void* ctx)
+    { if (!inserted) *value += *(int*)ctx; }
+
+TEST(sync_map, basics) {
+    IMap m = IMap_with_capacity(1000);
+    EXPECT_EQ(8, IMap_shard_count(&m));
+    for (c_range32(i, 1000))
+        EXPECT_TRUE(IMap_insert(&m, i, i*10));
+    EXPECT_FALSE(IMap_insert(&m, 5, 0));
+    EXPECT_EQ(1000, IMap_size(&m));
+
+    int x = -1;
+    EXPECT_TRUE(IMap_find(&m, 5, &x));
+    EXPECT_EQ(50, x);
+    EXPECT_FALSE(IMap_find(&m, 1000, &x));
+    EXPECT_TRUE(IMap_contains(&m, 999));
+
+    EXPECT_FALSE(IMap_insert_or_assign(&m, 5, 7));
+    EXPECT_TRUE(IMap_find(&m, 5, &x));
+    EXPECT_EQ(7, x);
+
+    int two = 2;
+    EXPECT_FALSE(IMap_upsert(&m, 5, 0, add, &two));
+    EXPECT_TRUE(IMap_upsert(&m, 2000, 1, add, &two));
+    IMap_find(&m, 5, &x);
+    EXPECT_EQ(9, x);
+    IMap_find(&m, 2000, &x);
+    EXPECT_EQ(1, x);
+
+    EXPECT_EQ(1, IMap_erase(&m, 2000));
+    EXPECT_EQ(0, IMap_erase(&m, 2000));
+    EXPECT_FALSE(IMap_contains(&m, 2000));
+
+    // every shard is used, and iterating over them visits each entry once
+    long long sum = 0;
+    isize total = 0;
+    for (c_range(s, IMap_shard_count(&m))) {
+        IMap_shard* shard = IMap_lock_shard(&m, s);
+        EXPECT_TRUE(IMap_shard_size(shard) > 0);
+        total += IMap_shard_size(shard);
+        for (c_each(i, IMap_shard, *shard))
+            sum += i.ref->first;
+        IMap_unlock_shard(&m, s);
+    }
+    EXPECT_EQ(1000, total);
+    EXPECT_EQ(999*1000/2, sum);
+
+    IMap_clear(&m);
+    EXPECT_TRUE(IMap_is_empty(&m));
+    IMap_drop(&m);
+}
+
+TEST(sync_map, strings) {
+    SMap m = SMap_init();
+    EXPECT_TRUE(SMap_emplace(&m, "one", "1"));
+    EXPECT_FALSE(SMap_emplace(&m, "one", "x"));
+    EXPECT_TRUE(SMap_insert(&m, cstr_from("two"), cstr_from("2")));
+    EXPECT_FALSE(SMap_insert(&m, cstr_from("two"), cstr_from("x"))); // dropped
+    EXPECT_FALSE(SMap_insert_or_assign(&m, cstr_from("one"), cstr_from("uno")));
+
+    cstr s;
+    EXPECT_TRUE(SMap_find(&m, "one", &s));
+    EXPECT_STREQ("uno", cstr_str(&s));
+    cstr_drop(&s);
+    EXPECT_TRUE(SMap_find(&m, "two", NULL));
+    EXPECT_EQ(1, SMap_erase(&m, "two"));
+    EXPECT_EQ(1, SMap_size(&m));
+    SMap_drop(&m);
+}
+
+static void count_calls(cstr* value, bool inserted, void* ctx)
+    { (void)value; (void)inserted; *(int*)ctx += 1; }
+
+TEST(sync_map, out_of_memory) {
+    OMap m = OMap_init();
+    alloc_fails = true; // the shards can not grow: inserts fail once their tables are full
+    int n = 0;
+    for (c_range32(i, 100))
+        n += OMap_insert_or_assign(&m, i, cstr_from("a string which is too long for SSO"));
+    EXPECT_TRUE(n > 0 && n < 100);
+    EXPECT_EQ(n, OMap_size(&m));
+    EXPECT_FALSE(OMap_insert(&m, 1000, cstr_from("another string which is too long for SSO")));
+    int calls = 0;
+    EXPECT_FALSE(OMap_upsert(&m, 1000, "one thousand", count_calls, &calls));
+    EXPECT_EQ(0, calls);
+    EXPECT_EQ(n, OMap_size(&m));
+
+    alloc_fails = false;
+    EXPECT_TRUE(OMap_upsert(&m, 1000, "one thousand", count_calls, &calls));
+    EXPECT_EQ(1, calls);
+    EXPECT_FALSE(OMap_insert_or_assign(&m, 1000, cstr_from("1000")));
+    cstr s;
+    EXPECT_TRUE(OMap_find(&m, 1000, &s));
+    EXPECT_STREQ("1000", cstr_str(&s));
+    cstr_drop(&s);
+    OMap_drop(&m);
+}
+
+#if !defined __STDC_NO_THREADS__
+#include <threads.h>
+
+enum {N_THREADS = 4, N_KEYS = 500, N_ROUNDS = 20};
+static IMap shared;
+
+static int worker(void* arg) {
+    int id = (int)(intptr_t)arg, one = 1;
+    for (c_range(N_ROUNDS))
+        for (c_range32(k, N_KEYS)) {
+            IMap_upsert(&shared, k, 1, add, &one);
+            if (k % N_THREADS == id) { // each thread owns a range of keys to insert and erase
+                IMap_insert(&shared, N_KEYS + k, id);
+                EXPECT_EQ(1, IMap_erase(&shared, N_KEYS + k));
+            }
+        }
+    return 0;
+}
+
+TEST(sync_map, threads) {
+    thrd_t t[N_THREADS];
+    shared = IMap_init();
+    for (c_range(i, N_THREADS)) thrd_create(&t[i], worker, (void*)(intptr_t)i);
+    for (c_range(i, N_THREADS)) thrd_join(t[i], NULL);
+
+    EXPECT_EQ(N_KEYS, IMap_size(&shared));
+    for (c_range32(k, N_KEYS)) {
+        int x = 0;
+        EXPECT_TRUE(IMap_find(&shared, k, &x));
+        EXPECT_EQ(N_THREADS*N_ROUNDS, x);
+    }
+    IMap_drop(&shared);
+}
+#endif
@@ -32,3 +32,58 @@ TEST(vec, basics) {
 
     c_drop(IVec, &d, &res);
 }
+
+#define i_type FVec, float, (c_use_cmp)
+#include "stc/vec.h"
+#include "stc/random.h"
+
+TEST(vec, sort_parallel) {
+    FVec v = {0};
+    crand64_seed(1234);
+    for (c_range(300000))
+        FVec_push(&v, (float)crand64_real());
+    FVec w = FVec_clone(v);
+
+    FVec_sort(&v);
+    FVec_sort_parallel(&w, 4);
+    for (c_range(i, FVec_size(&v)))
+        ASSERT_TRUE(*FVec_at(&v, i) == *FVec_at(&w, i));
+
+    FVec_sort_parallel(&w, 8); // already sorted
+    EXPECT_TRUE(FVec_eq(&v, &w));
+    c_drop(FVec, &v, &w);
+}
+
+#define i_type UVec, uint64_t, (c_use_cmp)
+#define i_radix_key(x) *(x)
+#include "stc/vec.h"
+
+typedef struct { double when; int seq; } Event;
+#define i_type Events, Event
+#define i_less(x, y) x->when < y->when
+#define i_radix_key(x) c_radix_float(x->when)
+#include "stc/sort.h"
+
+TEST(vec, radix_sort) {
+    UVec v = {0};
+    crand64_seed(42);
+    for (c_range(100000))
+        UVec_push(&v, crand64_uint() >> (crand64_uint() & 63));
+    UVec w = UVec_clone(v);
+    UVec_sort(&v);
+    UVec_sort_lowhigh(&w, 0, UVec_size(&w) - 1);
+    EXPECT_TRUE(UVec_eq(&v, &w));
+
+    static Event ev[20000];
+    for (c_range32(i, c_arraylen(ev))) {
+        ev[i].when = (double)((int)(crand64_uint() % 2000) - 1000)*0.25;
+        ev[i].seq = i;
+    }
+    Events_sort_stable(ev, c_arraylen(ev));
+    for (c_range(i, 1, c_arraylen(ev))) {
+        ASSERT_TRUE(ev[i - 1].when <= ev[i].when);
+        if (ev[i - 1].when == ev[i].when)
+            ASSERT_TRUE(ev[i - 1].seq < ev[i].seq);
+    }
+    c_drop(UVec, &v, &w);
+}